@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <set>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+
+namespace vortex {
+
+// Buddy allocator for device local memory shared by all drivers.
+// The address range is carved into naturally aligned power-of-two blocks;
+// a request is rounded up to the next power of two (at least one cache
+// line), served from the smallest free block that fits, and merged back
+// with its buddy when released.
+class MemoryAllocator {
+public:
+    struct stats_t {
+        uint64_t total_size;    // bytes managed
+        uint64_t used_size;     // bytes held by live blocks
+        uint64_t requested;     // bytes asked for by live allocations
+        uint64_t free_size;     // bytes available
+        uint64_t largest_free;  // biggest single allocation currently possible
+        uint32_t num_allocs;    // live allocations
+        uint32_t free_blocks;   // blocks on the free lists
+        float    fragmentation; // 1 - largest_free / free_size
+    };
+
+    MemoryAllocator(uint64_t base_addr, uint64_t size, uint32_t min_block)
+        : base_addr_(base_addr)
+        , size_(size) {
+        min_order_ = log2ceil(min_block);
+        free_lists_.resize(64);
+        this->reset();
+    }
+
+    // release every allocation
+    void reset() {
+        for (auto& list : free_lists_) {
+            list.clear();
+        }
+        allocs_.clear();
+        requested_ = 0;
+
+        // carve [base, end) into maximal aligned blocks
+        uint64_t addr = align(base_addr_, 1ull << min_order_);
+        uint64_t end  = base_addr_ + size_;
+        while (addr + (1ull << min_order_) <= end) {
+            uint32_t order = min_order_;
+            while (order < 63
+                && 0 == (addr & ((1ull << (order + 1)) - 1))
+                && addr + (1ull << (order + 1)) <= end) {
+                ++order;
+            }
+            free_lists_[order].insert(addr);
+            addr += (1ull << order);
+        }
+    }
+
+    int allocate(uint64_t size, uint64_t* addr) {
+        if (0 == size || size > size_ || nullptr == addr)
+            return -1;
+
+        uint32_t order = std::max(log2ceil(size), min_order_);
+        if (order >= free_lists_.size())
+            return -1;
+
+        // smallest free block that fits
+        uint32_t k = order;
+        while (k < free_lists_.size() && free_lists_[k].empty()) {
+            ++k;
+        }
+        if (k == free_lists_.size())
+            return -1;
+
+        uint64_t block = *free_lists_[k].begin();
+        free_lists_[k].erase(free_lists_[k].begin());
+
+        // split down to the requested order, keeping the upper halves free
+        while (k > order) {
+            --k;
+            free_lists_[k].insert(block + (1ull << k));
+        }
+
+        allocs_[block] = {order, size};
+        requested_ += size;
+        *addr = block;
+        return 0;
+    }
+
+    int release(uint64_t addr) {
+        auto it = allocs_.find(addr);
+        if (it == allocs_.end())
+            return -1;
+
+        uint32_t order = it->second.order;
+        requested_ -= it->second.size;
+        allocs_.erase(it);
+
+        // merge with free buddies
+        uint64_t block = addr;
+        while (order + 1 < free_lists_.size()) {
+            uint64_t buddy = block ^ (1ull << order);
+            auto& list = free_lists_[order];
+            auto buddy_it = list.find(buddy);
+            if (buddy_it == list.end())
+                break;
+            list.erase(buddy_it);
+            block = std::min(block, buddy);
+            ++order;
+        }
+        free_lists_[order].insert(block);
+        return 0;
+    }
+
+    stats_t stats() const {
+        stats_t s = {};
+        s.total_size = size_;
+        s.num_allocs = allocs_.size();
+        s.requested  = requested_;
+        for (auto& a : allocs_) {
+            s.used_size += (1ull << a.second.order);
+        }
+        for (uint32_t k = 0; k < free_lists_.size(); ++k) {
+            auto n = free_lists_[k].size();
+            if (0 == n)
+                continue;
+            s.free_blocks += n;
+            s.free_size += n * (1ull << k);
+            s.largest_free = (1ull << k);
+        }
+        if (s.free_size != 0) {
+            s.fragmentation = 1.0f - float(double(s.largest_free) / double(s.free_size));
+        }
+        return s;
+    }
+
+private:
+
+    struct alloc_t {
+        uint32_t order;
+        uint64_t size;
+    };
+
+    static uint32_t log2ceil(uint64_t value) {
+        uint32_t r = 0;
+        while ((1ull << r) < value) {
+            ++r;
+        }
+        return r;
+    }
+
+    static uint64_t align(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    uint64_t base_addr_;
+    uint64_t size_;
+    uint32_t min_order_;
+    uint64_t requested_;
+    std::vector<std::set<uint64_t>> free_lists_;
+    std::unordered_map<uint64_t, alloc_t> allocs_;
+};
+
+}
@@ -0,0 +1,268 @@
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <vortex.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+class vx_event {
+public:
+    vx_event()
+        : done_(false)
+        , status_(0)
+        , refs_(1) {}
+
+    void signal(int status) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = status;
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    // wait until the deadline, returns VX_ERR_TIMEOUT on timeout
+    int wait(const std::chrono::steady_clock::time_point& deadline, bool infinite) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (infinite) {
+            cv_.wait(lock, [&]{ return done_; });
+        } else if (!cv_.wait_until(lock, deadline, [&]{ return done_; })) {
+            return VX_ERR_TIMEOUT;
+        }
+        return status_;
+    }
+
+    void retain() {
+        ++refs_;
+    }
+
+    void release() {
+        if (0 == --refs_) {
+            delete this;
+        }
+    }
+
+private:
+    bool done_;
+    int status_;
+    std::atomic<int> refs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class vx_queue {
+public:
+    vx_queue(vx_device_h hdevice)
+        : hdevice_(hdevice)
+        , is_done_(false)
+        , thread_(&vx_queue::thread_proc, this) {}
+
+    ~vx_queue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_done_ = true;
+            cv_.notify_all();
+        }
+        thread_.join();
+    }
+
+    vx_device_h device() const {
+        return hdevice_;
+    }
+
+    void push(const std::function<int()>& command, vx_event_h* hevent) {
+        auto event = new vx_event();
+        if (hevent) {
+            event->retain();
+            *hevent = event;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands_.push_back(command_t{command, event});
+        cv_.notify_all();
+    }
+
+private:
+
+    struct command_t {
+        std::function<int()> func;
+        vx_event* event;
+    };
+
+    void thread_proc() {
+        for (;;) {
+            command_t command;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&]{ return is_done_ || !commands_.empty(); });
+                // drain pending commands before exiting
+                if (commands_.empty())
+                    break;
+                command = commands_.front();
+                commands_.pop_front();
+            }
+            int status = command.func();
+            command.event->signal(status);
+            command.event->release();
+        }
+    }
+
+    vx_device_h hdevice_;
+    bool is_done_;
+    std::deque<command_t> commands_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+extern int vx_queue_create(vx_device_h hdevice, vx_queue_h* hqueue) {
+    if (nullptr == hdevice
+     || nullptr == hqueue)
+        return -1;
+
+    *hqueue = new vx_queue(hdevice);
+
+    return 0;
+}
+
+extern int vx_queue_release(vx_queue_h hqueue) {
+    if (nullptr == hqueue)
+        return -1;
+
+    delete ((vx_queue*)hqueue);
+
+    return 0;
+}
+
+extern int vx_enqueue_copy_to_dev(vx_queue_h hqueue, vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset, vx_event_h* hevent) {
+    if (nullptr == hqueue
+     || nullptr == hbuffer)
+        return -1;
+
+    auto queue = (vx_queue*)hqueue;
+    queue->push([=]() {
+        return vx_copy_to_dev(hbuffer, dev_maddr, size, src_offset);
+    }, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_copy_from_dev(vx_queue_h hqueue, vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dst_offset, vx_event_h* hevent) {
+    if (nullptr == hqueue
+     || nullptr == hbuffer)
+        return -1;
+
+    auto queue = (vx_queue*)hqueue;
+    queue->push([=]() {
+        return vx_copy_from_dev(hbuffer, dev_maddr, size, dst_offset);
+    }, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_flush_caches(vx_queue_h hqueue, size_t dev_maddr, size_t size, vx_event_h* hevent) {
+    if (nullptr == hqueue)
+        return -1;
+
+    auto queue = (vx_queue*)hqueue;
+    auto hdevice = queue->device();
+    queue->push([=]() {
+        return vx_flush_caches(hdevice, dev_maddr, size);
+    }, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_start(vx_queue_h hqueue, vx_event_h* hevent) {
+    if (nullptr == hqueue)
+        return -1;
+
+    auto queue = (vx_queue*)hqueue;
+    auto hdevice = queue->device();
+    queue->push([=]() {
+        int err = vx_start(hdevice);
+        if (err != 0)
+            return err;
+        return vx_ready_wait(hdevice, -1);
+    }, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_csr_set(vx_queue_h hqueue, int core_id, int addr, unsigned value, vx_event_h* hevent) {
+    if (nullptr == hqueue)
+        return -1;
+
+    auto queue = (vx_queue*)hqueue;
+    auto hdevice = queue->device();
+    queue->push([=]() {
+        return vx_csr_set(hdevice, core_id, addr, value);
+    }, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_csr_get(vx_queue_h hqueue, int core_id, int addr, unsigned* value, vx_event_h* hevent) {
+    if (nullptr == hqueue
+     || nullptr == value)
+        return -1;
+
+    auto queue = (vx_queue*)hqueue;
+    auto hdevice = queue->device();
+    queue->push([=]() {
+        return vx_csr_get(hdevice, core_id, addr, value);
+    }, hevent);
+
+    return 0;
+}
+
+extern int vx_wait_for_events(unsigned num_events, const vx_event_h* hevents, long long timeout) {
+    if (0 == num_events
+     || nullptr == hevents)
+        return -1;
+
+    bool infinite = (timeout < 0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(infinite ? 0 : timeout);
+
+    int ret = 0;
+    for (unsigned i = 0; i < num_events; ++i) {
+        auto event = (vx_event*)hevents[i];
+        if (nullptr == event)
+            return -1;
+        int err = event->wait(deadline, infinite);
+        if (err != 0 && 0 == ret) {
+            ret = err;
+        }
+    }
+
+    return ret;
+}
+
+extern int vx_event_release(vx_event_h hevent) {
+    if (nullptr == hevent)
+        return -1;
+
+    ((vx_event*)hevent)->release();
+
+    return 0;
+}
+
+extern int vx_queue_finish(vx_queue_h hqueue, long long timeout) {
+    if (nullptr == hqueue)
+        return -1;
+
+    // commands run in order, so waiting on a marker covers everything before it
+    vx_event_h hevent;
+    auto queue = (vx_queue*)hqueue;
+    queue->push([]() { return 0; }, &hevent);
+    int err = vx_wait_for_events(1, &hevent, timeout);
+    vx_event_release(hevent);
+
+    return err;
+}
@@ -4,13 +4,56 @@
 #include <vortex.h>
 #include <VX_config.h>
 
+#include <vector>
+#include "../../runtime/include/vx_launch.h"
+
+static const uint32_t buffer_transfer_size = 65536;
+
+static int upload_bytes(vx_buffer_h buffer, const void* content, size_t size, size_t dev_maddr) {
+  auto buf_ptr = (uint8_t*)vx_host_ptr(buffer);
+  size_t offset = 0;
+  while (offset < size) {
+    auto chunk_size = std::min<size_t>(buffer_transfer_size, size - offset);
+    std::memcpy(buf_ptr, (uint8_t*)content + offset, chunk_size);
+    int err = vx_copy_to_dev(buffer, dev_maddr + offset, chunk_size, 0);
+    if (err != 0)
+      return err;
+    offset += chunk_size;
+  }
+  return 0;
+}
+
+static int upload_startup(vx_buffer_h buffer) {
+#if defined(USE_SIMX)
+  auto buf_ptr = (uint8_t*)vx_host_ptr(buffer);
+
+  // default startup routine
+  ((uint32_t*)buf_ptr)[0] = 0xf1401073;
+  ((uint32_t*)buf_ptr)[1] = 0xf1401073;      
+  ((uint32_t*)buf_ptr)[2] = 0x30101073;
+  ((uint32_t*)buf_ptr)[3] = 0x800000b7;
+  ((uint32_t*)buf_ptr)[4] = 0x000080e7;
+  int err = vx_copy_to_dev(buffer, 0, 5 * 4, 0);
+  if (err != 0)
+    return err;
+
+  // newlib io simulator trap
+  ((uint32_t*)buf_ptr)[0] = 0x00008067;
+  err = vx_copy_to_dev(buffer, 0x70000000, 4, 0);
+  if (err != 0)
+    return err;
+#else
+  (void)buffer;
+#endif
+  return 0;
+}
+
 extern int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_t size) {
   int err = 0;
 
   if (NULL == content || 0 == size)
     return -1;
 
-  uint32_t buffer_transfer_size = 65536;
   unsigned kernel_base_addr;
   err = vx_dev_caps(device, VX_CAPS_KERNEL_BASE_ADDR, &kernel_base_addr);
   if (err != 0)
@@ -22,50 +65,112 @@ extern int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_
   if (err != 0)
     return -1; 
 
-  // get buffer address
-  auto buf_ptr = (uint8_t*)vx_host_ptr(buffer);
-
-#if defined(USE_SIMX)
-  // default startup routine
-  ((uint32_t*)buf_ptr)[0] = 0xf1401073;
-  ((uint32_t*)buf_ptr)[1] = 0xf1401073;      
-  ((uint32_t*)buf_ptr)[2] = 0x30101073;
-  ((uint32_t*)buf_ptr)[3] = 0x800000b7;
-  ((uint32_t*)buf_ptr)[4] = 0x000080e7;
-  err = vx_copy_to_dev(buffer, 0, 5 * 4, 0);
+  err = upload_startup(buffer);
   if (err != 0) {
     vx_buf_release(buffer);
     return err;
   }
 
-  // newlib io simulator trap
-  ((uint32_t*)buf_ptr)[0] = 0x00008067;
-  err = vx_copy_to_dev(buffer, 0x70000000, 4, 0);
+  //
+  // upload content
+  //
+
+  err = upload_bytes(buffer, content, size, kernel_base_addr);
   if (err != 0) {
     vx_buf_release(buffer);
     return err;
   }
-#endif
 
-  //
-  // upload content
-  //
+  // invalidate any previous launch list so the kernel runs alone
+  uint32_t magic = 0;
+  err = upload_bytes(buffer, &magic, sizeof(magic), LAUNCH_LIST_ADDR + VX_LAUNCH_MAGIC_OFF);
 
-  size_t offset = 0;
-  while (offset < size) {
-    auto chunk_size = std::min<size_t>(buffer_transfer_size, size - offset);
-    std::memcpy(buf_ptr, (uint8_t*)content + offset, chunk_size);
-    err = vx_copy_to_dev(buffer, kernel_base_addr + offset, chunk_size, 0);
-    if (err != 0) {
-      vx_buf_release(buffer);
-      return err;
+  vx_buf_release(buffer);
+
+  return err;
+}
+
+extern int vx_upload_launch_list(vx_device_h device, const vx_launch_t* launches, unsigned count) {
+  int err = 0;
+
+  if (NULL == launches || 0 == count || count > VX_LAUNCH_MAX_KERNELS)
+    return -1;
+
+  unsigned kernel_base_addr;
+  err = vx_dev_caps(device, VX_CAPS_KERNEL_BASE_ADDR, &kernel_base_addr);
+  if (err != 0)
+    return -1;
+
+  // the device always boots into the first kernel
+  if (launches[0].image_addr != kernel_base_addr)
+    return -1;
+
+  // the table only has room for VX_LAUNCH_MAX_CORES cursors
+  unsigned num_cores;
+  err = vx_dev_caps(device, VX_CAPS_MAX_CORES, &num_cores);
+  if (err != 0)
+    return -1;
+  if (num_cores > VX_LAUNCH_MAX_CORES) {
+    std::cout << "error: launch lists support up to " << VX_LAUNCH_MAX_CORES << " cores, the device has " << num_cores << std::endl;
+    return -1;
+  }
+
+  // build the launch table, chained argument blocks are packed after the entries
+  std::vector<uint8_t> table(VX_LAUNCH_ARGS_OFF, 0);
+  for (unsigned i = 0; i < count; ++i) {
+    auto& launch = launches[i];
+    if (NULL == launch.image || 0 == launch.image_size)
+      return -1;
+    if (launch.arg_size != 0 && NULL == launch.arg)
+      return -1;
+
+    uint32_t arg_src = 0;
+    if (i != 0 && launch.arg_size != 0) {
+      size_t offset = (table.size() + 3) & ~size_t(3);
+      if (offset + launch.arg_size > VX_LAUNCH_LIST_SIZE) {
+        std::cout << "error: launch list arguments exceed " << VX_LAUNCH_LIST_SIZE << " bytes" << std::endl;
+        return -1;
+      }
+      table.resize(offset + launch.arg_size);
+      std::memcpy(table.data() + offset, launch.arg, launch.arg_size);
+      arg_src = LAUNCH_LIST_ADDR + offset;
     }
-    offset += chunk_size;
+
+    auto entry = (uint32_t*)(table.data() + VX_LAUNCH_ENTRY_OFF + i * VX_LAUNCH_ENTRY_SIZE);
+    entry[VX_LAUNCH_PC / 4]       = launch.image_addr;
+    entry[VX_LAUNCH_ARG_DST / 4]  = launch.arg_addr;
+    entry[VX_LAUNCH_ARG_SRC / 4]  = arg_src;
+    entry[VX_LAUNCH_ARG_SIZE / 4] = (i != 0) ? launch.arg_size : 0;
+  }
+  ((uint32_t*)table.data())[VX_LAUNCH_MAGIC_OFF / 4] = VX_LAUNCH_MAGIC;
+  ((uint32_t*)table.data())[VX_LAUNCH_COUNT_OFF / 4] = count;
+
+  // allocate device buffer
+  vx_buffer_h buffer;
+  err = vx_alloc_shared_mem(device, buffer_transfer_size, &buffer);
+  if (err != 0)
+    return -1;
+
+  err = upload_startup(buffer);
+
+  // upload the kernel images
+  for (unsigned i = 0; i < count && 0 == err; ++i) {
+    err = upload_bytes(buffer, launches[i].image, launches[i].image_size, launches[i].image_addr);
+  }
+
+  // the first kernel reads its arguments directly
+  if (0 == err && launches[0].arg_size != 0) {
+    err = upload_bytes(buffer, launches[0].arg, launches[0].arg_size, launches[0].arg_addr);
+  }
+
+  // upload the table last, with every core's cursor reset
+  if (0 == err) {
+    err = upload_bytes(buffer, table.data(), table.size(), LAUNCH_LIST_ADDR);
   }
 
   vx_buf_release(buffer);
 
-  return 0;
+  return err;
 }
 
 extern int vx_upload_kernel_file(vx_device_h device, const char* filename) {
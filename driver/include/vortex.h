@@ -11,6 +11,10 @@ typedef void* vx_device_h;
 
 typedef void* vx_buffer_h;
 
+typedef void* vx_queue_h;
+
+typedef void* vx_event_h;
+
 // device caps ids
 #define VX_CAPS_VERSION           0x0 
 #define VX_CAPS_MAX_CORES         0x1
@@ -20,6 +24,11 @@ typedef void* vx_buffer_h;
 #define VX_CAPS_LOCAL_MEM_SIZE    0x5
 #define VX_CAPS_ALLOC_BASE_ADDR   0x6
 #define VX_CAPS_KERNEL_BASE_ADDR  0x7
+#define VX_CAPS_SIM_THREADS       0x8  // host threads simulating the device, 0 on hardware
+#define VX_CAPS_SIM_AFFINITY      0x9  // first host CPU they are pinned to, ~0 if unpinned
+
+// error codes; other failures return -1
+#define VX_ERR_TIMEOUT            (-2) // vx_wait_for_events() or vx_queue_finish() timed out
 
 // open the device and connect to it
 int vx_dev_open(vx_device_h* hdevice);
@@ -30,6 +39,10 @@ int vx_dev_close(vx_device_h hdevice);
 // return device configurations
 int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value);
 
+// limit RTL waveform capture to a cycle window or trigger, same spec as VX_TRACE
+// (e.g. "pc=0x80000100,length=5000,history=1000"); -1 when the driver has no waveforms
+int vx_dev_trace(vx_device_h hdevice, const char* spec);
+
 // Allocate shared buffer with device
 int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hbuffer);
 
@@ -42,6 +55,9 @@ int vx_buf_release(vx_buffer_h hbuffer);
 // allocate device memory and return address
 int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr);
 
+// release device memory
+int vx_free_dev_mem(vx_device_h hdevice, size_t dev_maddr);
+
 // Copy bytes from device local memory to buffer
 int vx_flush_caches(vx_device_h hdevice, size_t dev_maddr, size_t size);
 
@@ -63,6 +79,49 @@ int vx_csr_set(vx_device_h hdevice, int core_id, int addr, unsigned value);
 // get device constant registers
 int vx_csr_get(vx_device_h hdevice, int core_id, int addr, unsigned* value);
 
+/////////////////////////////// COMMAND QUEUE ////////////////////////////////
+
+// Commands are executed in order on a driver-owned worker thread.
+// Each enqueue call returns immediately; if hevent is not NULL it receives
+// an event handle that completes with the command's return code.
+// Buffers must stay alive until their command completes.
+
+// create a command queue for the device
+int vx_queue_create(vx_device_h hdevice, vx_queue_h* hqueue);
+
+// wait for pending commands and destroy the queue
+int vx_queue_release(vx_queue_h hqueue);
+
+// enqueue a copy from buffer to device local memory
+int vx_enqueue_copy_to_dev(vx_queue_h hqueue, vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset, vx_event_h* hevent);
+
+// enqueue a copy from device local memory to buffer
+int vx_enqueue_copy_from_dev(vx_queue_h hqueue, vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dst_offset, vx_event_h* hevent);
+
+// enqueue a cache flush
+int vx_enqueue_flush_caches(vx_queue_h hqueue, size_t dev_maddr, size_t size, vx_event_h* hevent);
+
+// enqueue a kernel launch; the event completes when the device is ready again
+int vx_enqueue_start(vx_queue_h hqueue, vx_event_h* hevent);
+
+// enqueue a device constant register write
+int vx_enqueue_csr_set(vx_queue_h hqueue, int core_id, int addr, unsigned value, vx_event_h* hevent);
+
+// enqueue a device constant register read into *value
+int vx_enqueue_csr_get(vx_queue_h hqueue, int core_id, int addr, unsigned* value, vx_event_h* hevent);
+
+// wait for all events with milliseconds timeout (negative waits forever)
+// returns the first non-zero command status, or VX_ERR_TIMEOUT if an event
+// had not completed by the deadline
+int vx_wait_for_events(unsigned num_events, const vx_event_h* hevents, long long timeout);
+
+// release an event handle
+int vx_event_release(vx_event_h hevent);
+
+// wait for all commands enqueued so far with milliseconds timeout,
+// returns VX_ERR_TIMEOUT as vx_wait_for_events() does
+int vx_queue_finish(vx_queue_h hqueue, long long timeout);
+
 ////////////////////////////// UTILITY FUNCIONS ///////////////////////////////
 
 // upload kernel bytes to device
@@ -71,6 +130,20 @@ int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_t size)
 // upload kernel file to device
 int vx_upload_kernel_file(vx_device_h device, const char* filename);
 
+// kernel entry of a launch list
+typedef struct {
+  const void* image;      // kernel binary
+  size_t      image_size;
+  size_t      image_addr; // link address, the first entry must use the kernel base address
+  const void* arg;        // argument block, NULL if none
+  size_t      arg_size;
+  size_t      arg_addr;   // device address the kernel reads its arguments from
+} vx_launch_t;
+
+// upload several kernels and their arguments at once; a single vx_start()
+// then runs them back-to-back on the device (up to 64 cores)
+int vx_upload_launch_list(vx_device_h device, const vx_launch_t* launches, unsigned count);
+
 // get performance counters
 int vx_get_perf(vx_device_h device, int core_id, size_t* cycles, size_t* instrs);
 
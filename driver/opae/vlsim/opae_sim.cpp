@@ -1,4 +1,5 @@
 #include "opae_sim.h"
+#include "../vortex_afu.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
@@ -8,10 +9,14 @@
 #define CCI_RQ_SIZE 16
 #define CCI_WQ_SIZE 16
 
-#define ENABLE_DRAM_STALLS
-#define DRAM_LATENCY 4
-#define DRAM_RQ_SIZE 16
-#define DRAM_STALLS_MODULO 16
+// with ENABLE_IDLE_DETECT (make IDLE_DETECT=1), park the clock thread once
+// the AFU is idle with no bus traffic, checking the AFU status every
+// IDLE_CHECK_CYCLES quiet cycles. The check is an MMIO status read driven
+// into the RTL, so it is off by default to keep the model's MMIO traffic
+// identical to the host's.
+#ifndef IDLE_CHECK_CYCLES
+#define IDLE_CHECK_CYCLES 64
+#endif
 
 uint64_t timestamp = 0;
 
@@ -19,7 +24,15 @@ double sc_time_stamp() {
   return timestamp;
 }
 
-opae_sim::opae_sim() {  
+static DramConfig dram_config() {
+  DramConfig config;
+  config.block_size = CACHE_BLOCK_SIZE;
+  config.from_env();
+  return config;
+}
+
+// Avalon returns read data in request order
+opae_sim::opae_sim() : dram_queue_(dram_config(), true) {  
   // force random values for unitialized signals  
   Verilated::randReset(2);
   Verilated::randSeed(50);
@@ -33,27 +46,36 @@ opae_sim::opae_sim() {
   Verilated::traceEverOn(true);
   trace_ = new VerilatedFstC();
   vortex_afu_->trace(trace_, 99);
-  trace_->open("trace.fst");
+  trace_ctl_.attach(trace_, "trace.fst");
+  {
+    TraceConfig config;
+    config.from_env();
+    trace_ctl_.configure(config, this->signal_probe(config.signal));
+  }
 #endif
 
   this->reset();
 
+  mmio_req_.state = MMIO_EMPTY;
+  parked_ = false;
   stop_ = false;
-  future_ = std::async(std::launch::async, [&]{                   
-      while (!stop_) {
-          std::lock_guard<std::mutex> guard(mutex_);
-          this->step();
-      }
-  }); 
+  thread_ = std::thread(&opae_sim::clock_thread, this);
 }
 
 opae_sim::~opae_sim() {  
   stop_ = true;
-  if (future_.valid()) {
-    future_.wait();
+  {
+    std::lock_guard<std::mutex> lock(park_mutex_);
+    park_cv_.notify_all();
   }
+  thread_.join();
+#ifdef DUMP_PERF_STATS
+  std::cout << "[VXDRV] PERF: dram: ";
+  dram_queue_.dram().print_stats(std::cout);
+  std::cout << std::endl;
+#endif
 #ifdef VCD_OUTPUT
-  trace_->close();
+  trace_ctl_.close();
 #endif     
   delete vortex_afu_;
 }
@@ -86,28 +108,11 @@ void opae_sim::get_io_address(uint64_t wsid, uint64_t *ioaddr) {
 }
 
 void opae_sim::read_mmio64(uint32_t mmio_num, uint64_t offset, uint64_t *value) {
-  std::lock_guard<std::mutex> guard(mutex_);
-
-  vortex_afu_->vcp2af_sRxPort_c0_mmioRdValid = 1;
-  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_address = offset / 4;
-  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_length = 1;
-  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_tid = 0;
-  this->step();  
-  vortex_afu_->vcp2af_sRxPort_c0_mmioRdValid = 0;
-  assert(vortex_afu_->af2cp_sTxPort_c2_mmioRdValid);  
-  *value = vortex_afu_->af2cp_sTxPort_c2_data;
+  this->post_mmio(false, offset, value);
 }
 
 void opae_sim::write_mmio64(uint32_t mmio_num, uint64_t offset, uint64_t value) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  
-  vortex_afu_->vcp2af_sRxPort_c0_mmioWrValid = 1;  
-  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_address = offset / 4;
-  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_length = 1;
-  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_tid = 0;
-  memcpy(vortex_afu_->vcp2af_sRxPort_c0_data, &value, 8);
-  this->step();
-  vortex_afu_->vcp2af_sRxPort_c0_mmioWrValid = 0;
+  this->post_mmio(true, offset, &value);
 }
 
 void opae_sim::flush() {
@@ -119,7 +124,7 @@ void opae_sim::flush() {
 void opae_sim::reset() {
   
   host_buffers_.clear();
-  dram_reads_.clear();
+  dram_queue_.clear();
   cci_reads_.clear();
   cci_writes_.clear();
   vortex_afu_->vcp2af_sRxPort_c0_rspValid = 0;  
@@ -158,14 +163,129 @@ void opae_sim::step() {
 #endif
 }
 
+void opae_sim::clock_thread() {
+#ifdef ENABLE_IDLE_DETECT
+  uint32_t idle_cycles = 0;
+#endif
+  while (!stop_) {
+    if (MMIO_PENDING == mmio_req_.state.load(std::memory_order_acquire)) {
+      this->serve_mmio();
+    #ifdef ENABLE_IDLE_DETECT
+      idle_cycles = 0;
+    #endif
+      continue;
+    }
+
+    this->step();
+
+  #ifdef ENABLE_IDLE_DETECT
+    if (this->bus_active()) {
+      idle_cycles = 0;
+      continue;
+    }
+    if (++idle_cycles < IDLE_CHECK_CYCLES)
+      continue;
+    idle_cycles = 0;
+    if (0 == this->mmio_read(AFU_IMAGE_MMIO_STATUS * 4)) {
+      this->park();
+    }
+  #endif
+  }
+}
+
+// Hand an MMIO access to the clock thread and wait for it to be served.
+// The mailbox is lock-free; the clock thread is only signalled if parked.
+void opae_sim::post_mmio(bool write, uint64_t offset, uint64_t *value) {
+  std::lock_guard<std::mutex> guard(host_mutex_);
+
+  mmio_req_.write  = write;
+  mmio_req_.offset = offset;
+  mmio_req_.value  = *value;
+  mmio_req_.state.store(MMIO_PENDING);
+
+  if (parked_) {
+    std::lock_guard<std::mutex> lock(park_mutex_);
+    park_cv_.notify_one();
+  }
+
+  while (MMIO_DONE != mmio_req_.state.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+
+  *value = mmio_req_.value;
+  mmio_req_.state.store(MMIO_EMPTY, std::memory_order_release);
+}
+
+void opae_sim::serve_mmio() {
+  if (mmio_req_.write) {
+    this->mmio_write(mmio_req_.offset, mmio_req_.value);
+  } else {
+    mmio_req_.value = this->mmio_read(mmio_req_.offset);
+  }
+  mmio_req_.state.store(MMIO_DONE, std::memory_order_release);
+}
+
+uint64_t opae_sim::mmio_read(uint64_t offset) {
+  vortex_afu_->vcp2af_sRxPort_c0_mmioRdValid = 1;
+  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_address = offset / 4;
+  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_length = 1;
+  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_tid = 0;
+  this->step();  
+  vortex_afu_->vcp2af_sRxPort_c0_mmioRdValid = 0;
+  assert(vortex_afu_->af2cp_sTxPort_c2_mmioRdValid);  
+  return vortex_afu_->af2cp_sTxPort_c2_data;
+}
+
+void opae_sim::mmio_write(uint64_t offset, uint64_t value) {
+  vortex_afu_->vcp2af_sRxPort_c0_mmioWrValid = 1;  
+  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_address = offset / 4;
+  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_length = 1;
+  vortex_afu_->vcp2af_sRxPort_c0_ReqMmioHdr_tid = 0;
+  memcpy(vortex_afu_->vcp2af_sRxPort_c0_data, &value, 8);
+  this->step();
+  vortex_afu_->vcp2af_sRxPort_c0_mmioWrValid = 0;
+}
+
+bool opae_sim::bus_active() const {
+  return !cci_reads_.empty()
+      || !cci_writes_.empty()
+      || dram_queue_.size() != 0
+      || vortex_afu_->af2cp_sTxPort_c0_valid
+      || vortex_afu_->af2cp_sTxPort_c1_valid
+      || vortex_afu_->avs_read
+      || vortex_afu_->avs_write;
+}
+
+// Sleep until the host posts an MMIO request or the simulator shuts down.
+void opae_sim::park() {
+  std::unique_lock<std::mutex> lock(park_mutex_);
+  parked_ = true;
+  park_cv_.wait(lock, [&]{ 
+    return stop_ || (MMIO_PENDING == mmio_req_.state.load()); 
+  });
+  parked_ = false;
+}
+
 void opae_sim::eval() {  
   vortex_afu_->eval();
 #ifdef VCD_OUTPUT
-  trace_->dump(timestamp);
+  trace_ctl_.dump(timestamp);
 #endif
   ++timestamp;
 }
 
+#ifdef VCD_OUTPUT
+std::function<bool()> opae_sim::signal_probe(const std::string& name) {
+  if (name == "avs_read")           return [this]() { return vortex_afu_->avs_read != 0; };
+  if (name == "avs_write")          return [this]() { return vortex_afu_->avs_write != 0; };
+  if (name == "avs_readdatavalid")  return [this]() { return vortex_afu_->avs_readdatavalid != 0; };
+  if (name == "cci_read")           return [this]() { return vortex_afu_->af2cp_sTxPort_c0_valid != 0; };
+  if (name == "cci_write")          return [this]() { return vortex_afu_->af2cp_sTxPort_c1_valid != 0; };
+  if (name == "mmio_write")         return [this]() { return vortex_afu_->vcp2af_sRxPort_c0_mmioWrValid != 0; };
+  return nullptr;
+}
+#endif
+
 void opae_sim::sRxPort_bus() {      
   // check mmio request
   bool mmio_req_enabled = vortex_afu_->vcp2af_sRxPort_c0_mmioRdValid
@@ -247,56 +367,39 @@ void opae_sim::sTxPort_bus() {
 }
   
 void opae_sim::avs_bus() {
-  // schedule DRAM read responses
-  std::list<dram_rd_req_t>::iterator dram_rd_it(dram_reads_.end());
-  for (auto it = dram_reads_.begin(), ie = dram_reads_.end(); it != ie; ++it) {
-    if (it->cycles_left > 0) {
-      it->cycles_left -= 1;
-    }
-    if ((it != ie) && (it->cycles_left == 0)) {
-      dram_rd_it = it;
-    }
-  }
+  uint64_t cycle = timestamp / 2;
 
   // send DRAM response  
   vortex_afu_->avs_readdatavalid = 0;  
-  if (dram_rd_it != dram_reads_.end()) {
+  auto dram_rd = dram_queue_.front(cycle);
+  if (dram_rd) {
     vortex_afu_->avs_readdatavalid = 1;
-    memcpy(vortex_afu_->avs_readdata, dram_rd_it->block.data(), CACHE_BLOCK_SIZE);
-    dram_reads_.erase(dram_rd_it);
+    memcpy(vortex_afu_->avs_readdata, dram_rd->block.data(), CACHE_BLOCK_SIZE);
+    dram_queue_.pop();
   }
 
   // handle DRAM stalls
-  bool dram_stalled = false;
-#ifdef ENABLE_DRAM_STALLS
-  if (0 == ((timestamp/2) % DRAM_STALLS_MODULO)) { 
-    dram_stalled = true;
-  } else
-  if (dram_reads_.size() >= DRAM_RQ_SIZE) {
-    dram_stalled = true;
-  }
-#endif
+  bool dram_stalled = !dram_queue_.ready(cycle);
 
   // process DRAM requests
   if (!dram_stalled) {
+    unsigned base_addr = (vortex_afu_->avs_address * CACHE_BLOCK_SIZE);
     if (vortex_afu_->avs_write) {
       assert(0 == vortex_afu_->mem_bank_select);
       uint64_t byteen = vortex_afu_->avs_byteenable;
-      unsigned base_addr = (vortex_afu_->avs_address * CACHE_BLOCK_SIZE);
       uint8_t* data = (uint8_t*)(vortex_afu_->avs_writedata);
       for (int i = 0; i < CACHE_BLOCK_SIZE; i++) {
         if ((byteen >> i) & 0x1) {            
           ram_[base_addr + i] = data[i];
         }
       }
+      dram_queue_.write(base_addr, cycle);
     }
     if (vortex_afu_->avs_read) {
       assert(0 == vortex_afu_->mem_bank_select);
       dram_rd_req_t dram_req;
-      dram_req.cycles_left = DRAM_LATENCY;     
-      unsigned base_addr = (vortex_afu_->avs_address * CACHE_BLOCK_SIZE);
       ram_.read(base_addr, CACHE_BLOCK_SIZE, dram_req.block.data());
-      dram_reads_.emplace_back(dram_req);
+      dram_queue_.read(base_addr, cycle, dram_req);
     }   
   }
 
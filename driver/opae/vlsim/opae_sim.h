@@ -9,10 +9,15 @@
 #endif
 
 #include <VX_config.h>
-#include "ram.h"
+#include <ram.h>
+#include <dram_sim.h>
+#include <trace_ctl.h>
 
 #include <ostream>
-#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <list>
 #include <unordered_map>
 
@@ -39,9 +44,7 @@ public:
 private: 
 
   typedef struct {
-    int cycles_left;  
     std::array<uint8_t, CACHE_BLOCK_SIZE> block;
-    uint32_t tag;
   } dram_rd_req_t;
 
   typedef struct {
@@ -62,32 +65,65 @@ private:
     uint64_t  ioaddr;  
   } host_buffer_t;
 
+  // single-entry MMIO mailbox between the host and the clock thread
+  enum { MMIO_EMPTY, MMIO_PENDING, MMIO_DONE };
+
+  typedef struct {
+    std::atomic<int> state;
+    bool     write;
+    uint64_t offset;
+    uint64_t value;
+  } mmio_req_t;
+
   void reset();
 
   void eval();
 
   void step();
 
+  void clock_thread();
+
+  void post_mmio(bool write, uint64_t offset, uint64_t *value);
+
+  void serve_mmio();
+
+  uint64_t mmio_read(uint64_t offset);
+
+  void mmio_write(uint64_t offset, uint64_t value);
+
+  bool bus_active() const;
+
+  void park();
+
   void sRxPort_bus();
   void sTxPort_bus();
   void avs_bus();
 
-  std::future<void> future_;
-  bool stop_;
+  std::thread thread_;
+  std::atomic<bool> stop_;
 
   std::unordered_map<int64_t, host_buffer_t> host_buffers_;
 
-  std::list<dram_rd_req_t> dram_reads_;
+  DramQueue<dram_rd_req_t> dram_queue_;
 
   std::list<cci_rd_req_t> cci_reads_;
 
   std::list<cci_wr_req_t> cci_writes_;
 
-  std::mutex mutex_;
+  mmio_req_t mmio_req_;
+
+  // serializes host threads on the mailbox; never taken by the clock thread
+  std::mutex host_mutex_;
+
+  std::atomic<bool> parked_;
+  std::mutex park_mutex_;
+  std::condition_variable park_cv_;
 
   RAM ram_;
   Vvortex_afu_shim *vortex_afu_;
 #ifdef VCD_OUTPUT
+  std::function<bool()> signal_probe(const std::string& name);
   VerilatedFstC *trace_;
+  TraceControl<VerilatedFstC> trace_ctl_;
 #endif
 };
\ No newline at end of file
@@ -16,6 +16,7 @@
 
 #include <vortex.h>
 #include <VX_config.h>
+#include "../common/vx_malloc.h"
 #include "vortex_afu.h"
 
 #ifdef SCOPE
@@ -59,7 +60,7 @@
 
 typedef struct vx_device_ {
     fpga_handle fpga;
-    size_t mem_allocation;
+    vortex::MemoryAllocator* mem_allocator;
     unsigned implementation_id;
     unsigned num_cores;
     unsigned num_warps;
@@ -117,6 +118,16 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
     case VX_CAPS_KERNEL_BASE_ADDR:
         *value = STARTUP_ADDR;
         break;
+    case VX_CAPS_SIM_THREADS:
+#ifdef USE_VLSIM
+        *value = 1;
+#else
+        *value = 0;
+#endif
+        break;
+    case VX_CAPS_SIM_AFFINITY:
+        *value = ~0u;
+        break;
     default:
         fprintf(stderr, "[VXDRV] Error: invalid caps id: %d\n", caps_id);
         std::abort();
@@ -126,6 +137,11 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
     return 0;
 }
 
+extern int vx_dev_trace(vx_device_h /*hdevice*/, const char* /*spec*/) {
+    // vlsim takes VX_TRACE only
+    return -1;
+}
+
 extern int vx_dev_open(vx_device_h* hdevice) {
     if (nullptr == hdevice)
         return  -1;
@@ -184,7 +200,7 @@ extern int vx_dev_open(vx_device_h* hdevice) {
     }
 
     device->fpga = accel_handle;
-    device->mem_allocation = ALLOC_BASE_ADDR;
+    device->mem_allocator = new vortex::MemoryAllocator(ALLOC_BASE_ADDR, LOCAL_MEM_SIZE - ALLOC_BASE_ADDR + 1, CACHE_BLOCK_SIZE);
 
     {   
         // Load device CAPS
@@ -250,10 +266,16 @@ extern int vx_dev_close(vx_device_h hdevice) {
         assert(ret == 0);
         fprintf(stdout, "[VXDRV] PERF: instrs=%ld, cycles=%ld, IPC=%f\n", instrs, cycles, IPC);        
     }
+    auto mem = device->mem_allocator->stats();
+    fprintf(stdout, "[VXDRV] PERF: mem: allocs=%d, requested=%ld, used=%ld, free=%ld, largest_free=%ld, fragmentation=%f\n", 
+            mem.num_allocs, mem.requested, mem.used_size, mem.free_size, mem.largest_free, mem.fragmentation);
 #endif
 
     fpgaClose(device->fpga);
 
+    delete device->mem_allocator;
+    free(device);
+
     return 0;
 }
 
@@ -265,18 +287,23 @@ extern int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr)
 
     vx_device_t *device = ((vx_device_t*)hdevice);
 
-    size_t dev_mem_size = LOCAL_MEM_SIZE;
-    size_t asize = align_size(size, CACHE_BLOCK_SIZE);
-    
-    if (device->mem_allocation + asize > dev_mem_size)
+    uint64_t addr;
+    if (device->mem_allocator->allocate(size, &addr) != 0)
         return -1;   
 
-    *dev_maddr = device->mem_allocation;
-    device->mem_allocation += asize;
+    *dev_maddr = addr;
 
     return 0;
 }
 
+extern int vx_free_dev_mem(vx_device_h hdevice, size_t dev_maddr) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device_t *device = ((vx_device_t*)hdevice);
+    return device->mem_allocator->release(dev_maddr);
+}
+
 extern int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hbuffer) {
     fpga_result res;
     void* host_ptr;
@@ -7,6 +7,7 @@
 #include <chrono>
 
 #include <vortex.h>
+#include "../common/vx_malloc.h"
 #include <VX_config.h>
 #include <ram.h>
 #include <simulator.h>
@@ -63,9 +64,8 @@ private:
 
 class vx_device {    
 public:
-    vx_device() {        
-        mem_allocation_ = ALLOC_BASE_ADDR;        
-    } 
+    vx_device() 
+        : mem_allocator_(ALLOC_BASE_ADDR, LOCAL_MEM_SIZE - ALLOC_BASE_ADDR + 1, CACHE_LINESIZE) {} 
 
     ~vx_device() {    
         if (future_.valid()) {
@@ -74,15 +74,25 @@ public:
     }
 
     int alloc_local_mem(size_t size, size_t* dev_maddr) {
-        auto dev_mem_size = LOCAL_MEM_SIZE;
-        size_t asize = align_size(size, CACHE_LINESIZE);        
-        if (mem_allocation_ + asize > dev_mem_size)
+        uint64_t addr;
+        if (mem_allocator_.allocate(size, &addr) != 0)
             return -1;
-        *dev_maddr = mem_allocation_;
-        mem_allocation_ += asize;
+        *dev_maddr = addr;
         return 0;
     }
 
+    int free_local_mem(size_t dev_maddr) {
+        return mem_allocator_.release(dev_maddr);
+    }
+
+    vortex::MemoryAllocator::stats_t mem_stats() const {
+        return mem_allocator_.stats();
+    }
+
+    const DramSim& dram() const {
+        return simulator_.dram();
+    }
+
     int upload(void* src, size_t dest_addr, size_t size, size_t src_offset) {
         size_t asize = align_size(size, CACHE_LINESIZE);
         if (dest_addr + asize > ram_.size())
@@ -112,6 +122,13 @@ public:
         return 0;
     }
 
+    int set_trace(const char* spec) {
+        if (future_.valid()) {
+            future_.wait(); // not while the simulator is running
+        }
+        return simulator_.set_trace(spec) ? 0 : -1;
+    }
+
     int start() {   
         if (future_.valid()) {
             future_.wait(); // ensure prior run completed
@@ -129,15 +146,12 @@ public:
     int wait(long long timeout) {
         if (!future_.valid())
             return 0;
-        auto timeout_sec = (timeout < 0) ? timeout : (timeout / 1000);
-        std::chrono::seconds wait_time(1);
-        for (;;) {
-            auto status = future_.wait_for(wait_time); // wait for 1 sec and check status
-            if (status == std::future_status::ready 
-             || 0 == timeout_sec--)
-                break;
+        if (timeout < 0) {
+            future_.wait();
+            return 0;
         }
-        return 0;
+        auto status = future_.wait_for(std::chrono::milliseconds(timeout));
+        return (status == std::future_status::ready) ? 0 : -1;
     }
 
     int flush_caches(size_t dev_maddr, size_t size) {
@@ -177,7 +191,7 @@ public:
 
 private:
 
-    size_t mem_allocation_;     
+    vortex::MemoryAllocator mem_allocator_;
     RAM ram_;
     Simulator simulator_;
     std::future<void> future_;
@@ -214,6 +228,16 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
     case VX_CAPS_KERNEL_BASE_ADDR:
         *value = STARTUP_ADDR;
         break;
+    case VX_CAPS_SIM_THREADS:
+        *value = SIM_THREADS;
+        break;
+    case VX_CAPS_SIM_AFFINITY:
+#ifdef SIM_AFFINITY
+        *value = SIM_AFFINITY;
+#else
+        *value = ~0u;
+#endif
+        break;
     default:
         std::cout << "invalid caps id: " << caps_id << std::endl;
         std::abort();
@@ -223,6 +247,14 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
     return 0;
 }
 
+extern int vx_dev_trace(vx_device_h hdevice, const char* spec) {
+    if (nullptr == hdevice || nullptr == spec)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return device->set_trace(spec);
+}
+
 extern int vx_dev_open(vx_device_h* hdevice) {
     if (nullptr == hdevice)
         return  -1;
@@ -259,6 +291,12 @@ extern int vx_dev_close(vx_device_h hdevice) {
         float IPC = (float)(double(instrs) / double(cycles));
         fprintf(stdout, "PERF: instrs=%ld, cycles=%ld, IPC=%f\n", instrs, cycles, IPC);        
     }
+    auto mem = device->mem_stats();
+    fprintf(stdout, "PERF: mem: allocs=%d, requested=%ld, used=%ld, free=%ld, largest_free=%ld, fragmentation=%f\n", 
+            mem.num_allocs, mem.requested, mem.used_size, mem.free_size, mem.largest_free, mem.fragmentation);
+    std::cout << "PERF: dram: ";
+    device->dram().print_stats(std::cout);
+    std::cout << std::endl;
 #endif
 
     delete device;
@@ -276,6 +314,14 @@ extern int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr)
     return device->alloc_local_mem(size, dev_maddr);
 }
 
+extern int vx_free_dev_mem(vx_device_h hdevice, size_t dev_maddr) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return device->free_local_mem(dev_maddr);
+}
+
 extern int vx_flush_caches(vx_device_h hdevice, size_t dev_maddr, size_t size) {
     if (nullptr == hdevice 
      || 0 >= size)
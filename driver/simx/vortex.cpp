@@ -5,9 +5,14 @@
 #include <iostream>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
+#include <vector>
+#include <memory>
+#include <sstream>
 
 #include <vortex.h>
+#include "../common/vx_malloc.h"
 #include <core.h>
 #include <VX_config.h>
 
@@ -67,28 +72,35 @@ public:
     vx_device() 
         : is_done_(false)
         , is_running_(false)
-        , thread_(__thread_proc__, this)  {
-        mem_allocation_ = ALLOC_BASE_ADDR;
-    }
+        , mem_allocator_(ALLOC_BASE_ADDR, LOCAL_MEM_SIZE - ALLOC_BASE_ADDR + 1, CACHE_LINESIZE)
+        , perf_(NUM_CORES * NUM_CLUSTERS)
+        , thread_(__thread_proc__, this)  {}
 
     ~vx_device() {
-        mutex_.lock();
-        is_done_ = true;
-        mutex_.unlock();
-        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_done_ = true;
+            cv_.notify_all();
+        }
         thread_.join();
     }
 
     int alloc_local_mem(size_t size, size_t* dev_maddr) {
-        auto dev_mem_size = LOCAL_MEM_SIZE;
-        auto asize = align_size(size, CACHE_LINESIZE);        
-        if (mem_allocation_ + asize > dev_mem_size)
+        uint64_t addr;
+        if (mem_allocator_.allocate(size, &addr) != 0)
             return -1;
-        *dev_maddr = mem_allocation_;
-        mem_allocation_ += asize;
+        *dev_maddr = addr;
         return 0;
     }
 
+    int free_local_mem(size_t dev_maddr) {
+        return mem_allocator_.release(dev_maddr);
+    }
+
+    vortex::MemoryAllocator::stats_t mem_stats() const {
+        return mem_allocator_.stats();
+    }
+
     int upload(void* src, size_t dest_addr, size_t size, size_t src_offset) {
         auto asize = align_size(size, CACHE_LINESIZE);
         if (dest_addr + asize > ram_.size())
@@ -119,67 +131,185 @@ public:
     }
 
     int start() {  
-
-        mutex_.lock();     
+        std::lock_guard<std::mutex> lock(mutex_);
         is_running_ = true;
-        mutex_.unlock();
-
+        cv_.notify_all();
         return 0;
     }
 
     int wait(long long timeout) {
-        auto timeout_sec = (timeout < 0) ? timeout : (timeout / 1000);
-        for (;;) {
-            mutex_.lock();
-            bool is_running = is_running_;
-            mutex_.unlock();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (timeout < 0) {
+            cv_.wait(lock, [&]{ return !is_running_; });
+            return 0;
+        }
+        bool ready = cv_.wait_for(lock, std::chrono::milliseconds(timeout), [&]{ return !is_running_; });
+        return ready ? 0 : -1;
+    }
 
-            if (!is_running || 0 == timeout_sec--)
-                break;
+    int get_csr(int core_id, int addr, unsigned *value) {
+        // the cores only exist while running; serve the last run's counters
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&]{ return !is_running_; });
 
-            std::this_thread::sleep_for(std::chrono::seconds(1));            
+        if (core_id < 0 || core_id >= (int)perf_.size())
+            return -1;
+
+        const perf_t& perf = perf_[core_id];
+        switch (addr) {
+        case CSR_CYCLE:     *value = (unsigned)perf.cycles; break;
+        case CSR_CYCLE_H:   *value = (unsigned)(perf.cycles >> 32); break;
+        case CSR_INSTRET:   *value = (unsigned)perf.instrs; break;
+        case CSR_INSTRET_H: *value = (unsigned)(perf.instrs >> 32); break;
+        case CSR_NT:        *value = NUM_THREADS; break;
+        case CSR_NW:        *value = NUM_WARPS; break;
+        case CSR_NC:        *value = perf_.size(); break;
+        default:
+            return -1;
         }
         return 0;
     }
 
 private:
 
+    struct perf_t {
+        perf_t() : cycles(0), instrs(0) {}
+        uint64_t cycles;
+        uint64_t instrs;
+    };
+
     void run() {        
         Harp::ArchDef arch("rv32i", NUM_WARPS, NUM_THREADS);
+        Harp::GlobalBarrier global_barrier;
+        unsigned num_cores = NUM_CORES * NUM_CLUSTERS;
+
+        // VX_SIMX_FUNCTIONAL=1 skips the timing pipeline and cache model
+        auto functional = getenv("VX_SIMX_FUNCTIONAL");
+        bool is_functional = (functional != nullptr && atoi(functional) != 0);
+
+        // shared cache levels: one L2 per cluster, one L3 for the device
+        std::unique_ptr<Harp::Cache> l3cache;
+        std::vector<std::unique_ptr<Harp::Cache>> l2caches;
+        if (L3_ENABLE) {
+            l3cache.reset(new Harp::Cache(Harp::l3cacheConfig(), nullptr, true));
+        }
+        if (L2_ENABLE) {
+            for (unsigned i = 0; i < NUM_CLUSTERS; ++i) {
+                l2caches.emplace_back(new Harp::Cache(Harp::l2cacheConfig(), l3cache.get(), true));
+            }
+        }
+
+        // VX_SIMX_PROFILE=<prefix> writes <prefix>.json and <prefix>.prof after each run
+        auto profile = getenv("VX_SIMX_PROFILE");
+        bool is_profiled = (profile != nullptr && profile[0] != 0);
+        profiles_.clear();
+        profiles_.resize(num_cores);
+
+        // VX_SIMX_STATS=1 prints each core's cache and scheduler stats after each run
+        auto stats = getenv("VX_SIMX_STATS");
+        bool show_stats = (stats != nullptr && atoi(stats) != 0);
+        stats_.clear();
+        stats_.resize(num_cores);
+
+        // VX_SIMX_SCHED=<policy> selects the warp scheduler (lrr, gto, twolevel[:<n>])
+        auto sched = getenv("VX_SIMX_SCHED");
+        std::string sched_policy((sched != nullptr && sched[0] != 0) ? sched : "lrr");
+
+        // one host thread per core, all sharing the device RAM
+        std::vector<std::thread> core_threads;
+        for (unsigned i = 0; i < num_cores; ++i) {
+            Harp::Cache* next_level = L2_ENABLE ? l2caches[i / NUM_CORES].get() : l3cache.get();
+            core_threads.emplace_back([&, i, next_level]() {
+                this->run_core(arch, i, num_cores, &global_barrier, next_level, is_functional, is_profiled, show_stats, sched_policy);
+            });
+        }
+
+        for (auto& core_thread : core_threads) {
+            core_thread.join();
+        }
+
+        if (show_stats) {
+            for (unsigned i = 0; i < num_cores; ++i) {
+                std::cout << "core" << i << ":" << std::endl << stats_[i];
+            }
+        }
+
+        if (is_profiled) {
+            std::vector<const Harp::PerfCounters*> cores;
+            for (auto& p : profiles_) {
+                cores.push_back(p.get());
+            }
+            Harp::writeProfile(profile, cores);
+        }
+    }
+
+    void run_core(const Harp::ArchDef& arch, 
+                  unsigned core_id, 
+                  unsigned num_cores, 
+                  Harp::GlobalBarrier* global_barrier,
+                  Harp::Cache* next_level,
+                  bool is_functional,
+                  bool is_profiled,
+                  bool show_stats,
+                  const std::string& sched_policy) {
         Harp::WordDecoder dec(arch);
         Harp::MemoryUnit mu(PAGE_SIZE, arch.getWordSize(), true);
-        Harp::Core core(arch, dec, mu);
+        Harp::Core core(arch, dec, mu, core_id, num_cores, global_barrier, next_level);
+        core.functional = is_functional;
+        if (!core.setScheduler(sched_policy)) {
+            std::cerr << "Warning: unknown VX_SIMX_SCHED policy " << sched_policy << ", using lrr" << std::endl;
+        }
+        core.setTrace(trace_.get());
+        if (is_profiled) {
+            core.enableProfile();
+        }
         mu.attach(ram_, 0);  
 
         while (core.running()) { 
             core.step();
         }
-        core.printStats();
+
+        // printed by run() once all cores are done, so outputs do not interleave
+        if (show_stats) {
+            std::ostringstream os;
+            core.printStats(os);
+            stats_[core_id] = os.str();
+        }
+
+        perf_[core_id].cycles = core.num_cycles;
+        perf_[core_id].instrs = core.num_instructions;
+        profiles_[core_id] = std::move(core.perf);
     }
 
     void thread_proc() {
+        // VX_SIMX_TRACE=<file> records a binary trace of every run (see simX/trace_decode.run)
+        auto trace_file = getenv("VX_SIMX_TRACE");
+        if (trace_file != nullptr && trace_file[0] != 0) {
+            trace_.reset(new Harp::TraceSink(trace_file));
+        }
+
         std::cout << "Device ready..." << std::endl;
 
         for (;;) {
-            mutex_.lock();
-            bool is_done = is_done_;
-            bool is_running = is_running_;
-            mutex_.unlock();
-
-            if (is_done)
-                break;
+            {
+                // sleep until a kernel is started or the device is closed
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&]{ return is_done_ || is_running_; });
+                if (is_done_)
+                    break;
+            }
 
-            if (is_running) {                                
-                std::cout << "Device running..." << std::endl;
-                
-                this->run();
+            std::cout << "Device running..." << std::endl;
+            
+            this->run();
 
-                mutex_.lock();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
                 is_running_ = false;
-                mutex_.unlock();
-
-                std::cout << "Device ready..." << std::endl;
+                cv_.notify_all();
             }
+
+            std::cout << "Device ready..." << std::endl;
         }
 
         std::cout << "Device shutdown..." << std::endl;
@@ -191,10 +321,15 @@ private:
 
     bool is_done_;
     bool is_running_;   
-    size_t mem_allocation_; 
-    std::thread thread_;   
+    vortex::MemoryAllocator mem_allocator_;
     Harp::RAM ram_;
+    std::unique_ptr<Harp::TraceSink> trace_;
+    std::vector<perf_t> perf_;
+    std::vector<std::unique_ptr<Harp::PerfCounters>> profiles_;
+    std::vector<std::string> stats_;
     std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;   
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -214,6 +349,12 @@ extern int vx_dev_close(vx_device_h hdevice) {
 
     vx_device *device = ((vx_device*)hdevice);
 
+#ifdef DUMP_PERF_STATS
+    auto mem = device->mem_stats();
+    fprintf(stdout, "PERF: mem: allocs=%d, requested=%ld, used=%ld, free=%ld, largest_free=%ld, fragmentation=%f\n", 
+            mem.num_allocs, mem.requested, mem.used_size, mem.free_size, mem.largest_free, mem.fragmentation);
+#endif
+
     delete device;
 
     return 0;
@@ -228,7 +369,7 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
         *value = IMPLEMENTATION_ID;
         break;
     case VX_CAPS_MAX_CORES:
-        *value = NUM_CORES;        
+        *value = NUM_CORES * NUM_CLUSTERS;
         break;
     case VX_CAPS_MAX_WARPS:
         *value = NUM_WARPS;
@@ -248,6 +389,12 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
     case VX_CAPS_KERNEL_BASE_ADDR:
         *value = STARTUP_ADDR;
         break;
+    case VX_CAPS_SIM_THREADS:
+        *value = NUM_CORES * NUM_CLUSTERS;
+        break;
+    case VX_CAPS_SIM_AFFINITY:
+        *value = ~0u;
+        break;
     default:
         std::cout << "invalid caps id: " << caps_id << std::endl;
         std::abort();
@@ -257,6 +404,11 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
     return 0;
 }
 
+extern int vx_dev_trace(vx_device_h /*hdevice*/, const char* /*spec*/) {
+    // simX has no waveforms; see VX_SIMX_TRACE
+    return -1;
+}
+
 extern int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr) {
     if (nullptr == hdevice 
      || nullptr == dev_maddr
@@ -267,6 +419,14 @@ extern int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr)
     return device->alloc_local_mem(size, dev_maddr);
 }
 
+extern int vx_free_dev_mem(vx_device_h hdevice, size_t dev_maddr) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return device->free_local_mem(dev_maddr);
+}
+
 extern int vx_flush_caches(vx_device_h hdevice, size_t /*dev_maddr*/, size_t size) {
     if (nullptr == hdevice 
      || 0 >= size)
@@ -362,6 +522,12 @@ extern int vx_csr_set(vx_device_h /*hdevice*/, int /*core_id*/, int /*addr*/, un
     return -1;
 }
 
-extern int vx_csr_get(vx_device_h /*hdevice*/, int /*core_id*/, int /*addr*/, unsigned* /*value*/) {
-    return -1;
+extern int vx_csr_get(vx_device_h hdevice, int core_id, int addr, unsigned* value) {
+    if (nullptr == hdevice
+     || nullptr == value)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+
+    return device->get_csr(core_id, addr, value);
 }
\ No newline at end of file
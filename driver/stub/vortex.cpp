@@ -12,10 +12,18 @@ extern int vx_dev_caps(vx_device_h /*hdevice*/, unsigned /*caps_id*/, unsigned*
     return -1;
 }
 
+extern int vx_dev_trace(vx_device_h /*hdevice*/, const char* /*spec*/) {
+    return -1;
+}
+
 extern int vx_alloc_dev_mem(vx_device_h /*hdevice*/, size_t /*size*/, size_t* /*dev_maddr*/) {
     return -1;
 }
 
+extern int vx_free_dev_mem(vx_device_h /*hdevice*/, size_t /*dev_maddr*/) {
+    return -1;
+}
+
 extern int vx_flush_caches(vx_device_h /*hdevice*/, size_t /*dev_maddr*/, size_t /*size*/) {
     return -1;
 }
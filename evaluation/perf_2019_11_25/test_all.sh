@@ -16,9 +16,9 @@ for PROJECT in sfilter; do
 
             echo "Warps: $number_of_warps, Threads: $number_of_threads" >> $PROJECT.result
 
-            # echo ../../../simX/obj_dir/Vcache_simX -E -a rv32i --core ../opencl/$PROJECT/$PROJECT.hex -s -b &>> $PROJECT.result
+            # echo ../../../simX/simX.run -E -a rv32i --core ../opencl/$PROJECT/$PROJECT.hex -s -b &>> $PROJECT.result
 
-            ../../simX/obj_dir/Vcache_simX -E -a rv32i --core ../opencl/$PROJECT/$PROJECT.hex -s -b &>> $PROJECT.result
+            ../../simX/simX.run -E -a rv32i --core ../opencl/$PROJECT/$PROJECT.hex -s -b &>> $PROJECT.result
 
 
         done
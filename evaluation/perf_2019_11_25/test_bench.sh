@@ -17,7 +17,7 @@ for number_of_warps in 2 4 8 16 32; do
 
         echo "Warps: $number_of_warps, Threads: $number_of_threads" >> $PROJECT.result
 
-        ../../simX/obj_dir/Vcache_simX -E -a rv32i --core ../opencl/$PROJECT/$PROJECT.hex -s -b &>> $PROJECT.result
+        ../../simX/simX.run -E -a rv32i --core ../opencl/$PROJECT/$PROJECT.hex -s -b &>> $PROJECT.result
 
 
     done
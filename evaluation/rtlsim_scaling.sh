@@ -0,0 +1,81 @@
+#!/bin/bash
+# Verilator speedup vs host thread count for the rtlsim driver.
+# For each core configuration and thread count, rebuilds driver/rtlsim with
+# THREADS=<n> and times an OpenCL benchmark under run-rtlsim.
+#
+# usage: evaluation/rtlsim_scaling.sh [benchmark]   (run from the repo root)
+#   THREAD_COUNTS="1 2 4 8"  host threads to try; 1 is the single-threaded build
+#   CORE_COUNTS="1 2 4 16"   device cores
+#   AFFINITY=<cpu>           pin the model to CPUs cpu..cpu+n-1
+set -e
+
+bench=${1:-sgemm}
+thread_counts=${THREAD_COUNTS:-"1 2 4 8"}
+core_counts=${CORE_COUNTS:-"1 2 4 16"}
+
+if [ ! -d "benchmarks/opencl/$bench" ]; then
+	echo "Unknown benchmark $bench"
+	exit 1
+fi
+
+mkdir -p test_outputs
+output_dir="$(pwd)/test_outputs"
+result="$output_dir/rtlsim_scaling-$bench.csv"
+
+configs_for() {
+	case $1 in
+	1)  echo "-DNUM_CLUSTERS=1 -DNUM_CORES=1 -DL2_ENABLE=0" ;;
+	2)  echo "-DNUM_CLUSTERS=1 -DNUM_CORES=2 -DL2_ENABLE=0" ;;
+	4)  echo "-DNUM_CLUSTERS=1 -DNUM_CORES=4 -DL2_ENABLE=1" ;;
+	16) echo "-DNUM_CLUSTERS=4 -DNUM_CORES=4 -DL2_ENABLE=1" ;;
+	*)  echo "Unsupported core count $1" >&2; exit 1 ;;
+	esac
+}
+
+echo "cores,threads,seconds,cycles,khz,speedup" > "$result"
+
+for cores in $core_counts; do
+
+configs=$(configs_for $cores)
+base_seconds=""
+
+for threads in $thread_counts; do
+
+build_args="OPT=1"
+if [ "$threads" -gt 1 ]; then
+	build_args="THREADS=$threads"
+	if [ -n "$AFFINITY" ]; then
+		build_args="$build_args AFFINITY=$AFFINITY"
+	fi
+fi
+
+echo "Building rtlsim: cores=$cores $build_args"
+make -C driver/rtlsim clean > /dev/null
+make -C driver/rtlsim CONFIGS="$configs" $build_args > "$output_dir/rtlsim_build-$cores-$threads.log" 2>&1
+
+log="$output_dir/rtlsim_scaling-$bench-$cores-$threads.log"
+echo "Running $bench: cores=$cores threads=$threads"
+start=$(date +%s.%N)
+make -C "benchmarks/opencl/$bench" run-rtlsim > "$log" 2>&1
+end=$(date +%s.%N)
+
+seconds=$(echo "$end - $start" | bc)
+cycles=$(grep -o "PERF: instrs=[0-9]*, cycles=[0-9]*" "$log" | tail -1 | sed 's/.*cycles=//')
+cycles=${cycles:-0}
+if [ -z "$base_seconds" ]; then
+	base_seconds=$seconds
+fi
+khz=$(echo "scale=2; $cycles / $seconds / 1000" | bc)
+speedup=$(echo "scale=2; $base_seconds / $seconds" | bc)
+
+echo "  ${seconds}s, $cycles cycles, $khz KHz, speedup $speedup"
+echo "$cores,$threads,$seconds,$cycles,$khz,$speedup" >> "$result"
+
+done # threads
+
+done # cores
+
+# leave the default driver build in place
+make -C driver/rtlsim clean > /dev/null
+
+echo "Results in $result"
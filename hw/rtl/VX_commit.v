@@ -103,6 +103,20 @@ module VX_commit #(
         .writeback_if   (writeback_if)
     );
 
+`ifdef VCD_OUTPUT
+    // committed PCs feed the waveform PC trigger (hw/simulate/trace_ctl.h)
+    import "DPI-C" function void dpi_trace_pc(input int pc);
+
+    always @(posedge clk) begin
+        if (alu_commit_if.valid && alu_commit_if.ready) dpi_trace_pc(alu_commit_if.PC);
+        if (lsu_commit_if.valid && lsu_commit_if.ready) dpi_trace_pc(lsu_commit_if.PC);
+        if (csr_commit_if.valid && csr_commit_if.ready) dpi_trace_pc(csr_commit_if.PC);
+        if (mul_commit_if.valid && mul_commit_if.ready) dpi_trace_pc(mul_commit_if.PC);
+        if (fpu_commit_if.valid && fpu_commit_if.ready) dpi_trace_pc(fpu_commit_if.PC);
+        if (gpu_commit_if.valid && gpu_commit_if.ready) dpi_trace_pc(gpu_commit_if.PC);
+    end
+`endif
+
 `ifdef DBG_PRINT_PIPELINE
     always @(posedge clk) begin
         if (alu_commit_if.valid && alu_commit_if.ready) begin
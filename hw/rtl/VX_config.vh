@@ -35,6 +35,10 @@
 `define SHARED_MEM_BASE_ADDR 32'h6FFFF000
 `endif
 
+`ifndef LAUNCH_LIST_ADDR
+`define LAUNCH_LIST_ADDR 32'h7FFFC000
+`endif
+
 `ifndef IO_BUS_BASE_ADDR
 `define IO_BUS_BASE_ADDR 32'hFFFFFF00
 `endif
@@ -34,13 +34,12 @@ module VX_fp_addmul #(
 
     reg do_sub_r, do_mul_r;
 
+    `ifdef QUARTUS
     for (genvar i = 0; i < LANES; i++) begin
-        
         wire [31:0] result_add;
         wire [31:0] result_sub;
         wire [31:0] result_mul;
 
-    `ifdef QUARTUS
         twentynm_fp_mac mac_fp_add (
             // inputs
             .accumulate(),
@@ -160,22 +159,28 @@ module VX_fp_addmul #(
         defparam mac_fp_mul.mult_pipeline_clock = "0"; 
         defparam mac_fp_mul.adder_input_clock = "none"; 
         defparam mac_fp_mul.accum_adder_clock = "none";
+
+        assign result[i] = do_mul_r ? result_mul : (do_sub_r ? result_sub : result_add);
+    end
     `else
-        integer fadd_h, fsub_h, fmul_h;
+        // one call per cycle for the whole warp;
+        // the op is applied on entry, so the result needs no select
+        integer faddmul_h;
+        int dataa_l [LANES], datab_l [LANES], result_l [LANES];
         initial begin
-            fadd_h = dpi_register();
-            fsub_h = dpi_register();
-            fmul_h = dpi_register();
+            faddmul_h = dpi_register();
+        end
+        for (genvar i = 0; i < LANES; i++) begin
+            assign dataa_l[i] = dataa[i];
+            assign datab_l[i] = datab[i];
+            assign result[i] = result_l[i];
         end
         always @(posedge clk) begin
-           dpi_fadd(fadd_h, enable, dataa[i], datab[i], result_add);
-           dpi_fsub(fsub_h, enable, dataa[i], datab[i], result_sub);
-           dpi_fmul(fmul_h, enable, dataa[i], datab[i], result_mul);
+           dpi_faddmul(faddmul_h, enable, valid_in, do_sub, do_mul, dataa_l, datab_l, result_l);
         end
+        `UNUSED_VAR (do_sub_r)
+        `UNUSED_VAR (do_mul_r)
     `endif
-
-        assign result[i] = do_mul_r ? result_mul : (do_sub_r ? result_sub : result_add);
-    end
     
     VX_shift_register #(
         .DATAW(TAGW + 1 + 1 + 1),
@@ -28,8 +28,8 @@ module VX_fp_div #(
     wire stall = ~ready_out && valid_out;
     wire enable = ~stall;
     
-    for (genvar i = 0; i < LANES; i++) begin
     `ifdef QUARTUS
+    for (genvar i = 0; i < LANES; i++) begin
         acl_fdiv fdiv (
             .clk    (clk),
             .areset (reset),
@@ -38,16 +38,23 @@ module VX_fp_div #(
             .b      (datab[i]),
             .q      (result[i])
         );
-    `else 
+    end
+    `else
+        // one call per cycle for the whole warp
         integer fdiv_h;
+        int dataa_l [LANES], datab_l [LANES], result_l [LANES];
         initial begin
             fdiv_h = dpi_register();
         end
+        for (genvar i = 0; i < LANES; i++) begin
+            assign dataa_l[i] = dataa[i];
+            assign datab_l[i] = datab[i];
+            assign result[i] = result_l[i];
+        end
         always @(posedge clk) begin
-           dpi_fdiv(fdiv_h, enable, dataa[i], datab[i], result[i]);
+           dpi_fdiv(fdiv_h, enable, valid_in, dataa_l, datab_l, result_l);
         end
     `endif
-    end
 
     VX_shift_register #(
         .DATAW(TAGW + 1),
@@ -31,12 +31,11 @@ module VX_fp_ftoi #(
 
     reg is_signed_r;
     
+    `ifdef QUARTUS
     for (genvar i = 0; i < LANES; i++) begin
-
         wire [31:0] result_s;
         wire [31:0] result_u;
 
-    `ifdef QUARTUS       
         acl_ftoi ftoi (
             .clk    (clk),
             .areset (reset),
@@ -52,21 +51,27 @@ module VX_fp_ftoi #(
             .a      (dataa[i]),
             .q      (result_u)
         );        
+
+        assign result[i] = is_signed_r ? result_s : result_u;
+    end
     `else
-        integer ftoi_h, ftou_h;
+        // one call per cycle for the whole warp;
+        // is_signed is applied on entry, so the result needs no select
+        integer ftoi_h;
+        int dataa_l [LANES], result_l [LANES];
         initial begin
             ftoi_h = dpi_register();
-            ftou_h = dpi_register();
+        end
+        for (genvar i = 0; i < LANES; i++) begin
+            assign dataa_l[i] = dataa[i];
+            assign result[i] = result_l[i];
         end
         always @(posedge clk) begin
-           dpi_ftoi(ftoi_h, enable, dataa[i], result_s);
-           dpi_ftou(ftou_h, enable, dataa[i], result_u);
+           dpi_ftoi(ftoi_h, enable, valid_in, is_signed, dataa_l, result_l);
         end
+        `UNUSED_VAR (is_signed_r)
     `endif
 
-        assign result[i] = is_signed_r ? result_s : result_u;
-    end
-
     VX_shift_register #(
         .DATAW(TAGW + 1 + 1),
         .DEPTH(`LATENCY_FTOI)
@@ -35,12 +35,11 @@ module VX_fp_madd #(
 
     reg do_sub_r, do_neg_r;
 
+    `ifdef QUARTUS
     for (genvar i = 0; i < LANES; i++) begin
-        
         wire [31:0] result_madd;
         wire [31:0] result_msub;
 
-    `ifdef QUARTUS
         twentynm_fp_mac mac_fp_madd (
             // inputs
             .accumulate(),
@@ -120,22 +119,31 @@ module VX_fp_madd #(
         defparam mac_fp_msub.mult_pipeline_clock = "0"; 
         defparam mac_fp_msub.adder_input_clock = "0"; 
         defparam mac_fp_msub.accum_adder_clock = "none";
+
+        wire [31:0] result_unqual = do_sub_r ? result_msub : result_madd;
+        assign result[i][31]   = result_unqual[31] ^ do_neg_r;
+        assign result[i][30:0] = result_unqual[30:0];
+    end
     `else
-        integer fmadd_h, fmsub_h;
+        // one call per cycle for the whole warp;
+        // do_sub is applied on entry, do_neg on the result
+        integer fmadd_h;
+        int dataa_l [LANES], datab_l [LANES], datac_l [LANES], result_l [LANES];
         initial begin
             fmadd_h = dpi_register();
-            fmsub_h = dpi_register();
+        end
+        for (genvar i = 0; i < LANES; i++) begin
+            assign dataa_l[i] = dataa[i];
+            assign datab_l[i] = datab[i];
+            assign datac_l[i] = datac[i];
+            assign result[i][31]   = result_l[i][31] ^ do_neg_r;
+            assign result[i][30:0] = result_l[i][30:0];
         end
         always @(posedge clk) begin
-           dpi_fmadd(fmadd_h, enable, dataa[i], datab[i], datac[i], result_madd);
-           dpi_fmsub(fmsub_h, enable, dataa[i], datab[i], datac[i], result_msub);
+           dpi_fmadd(fmadd_h, enable, valid_in, do_sub, dataa_l, datab_l, datac_l, result_l);
         end
+        `UNUSED_VAR (do_sub_r)
     `endif
-
-        wire [31:0] result_unqual = do_sub_r ? result_msub : result_madd;
-        assign result[i][31]   = result_unqual[31] ^ do_neg_r;
-        assign result[i][30:0] = result_unqual[30:0];
-    end
     
     VX_shift_register #(
         .DATAW(TAGW + 1 + 1 + 1),
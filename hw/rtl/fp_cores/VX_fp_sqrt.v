@@ -27,8 +27,8 @@ module VX_fp_sqrt #(
     wire stall = ~ready_out && valid_out;
     wire enable = ~stall;
     
-    for (genvar i = 0; i < LANES; i++) begin
     `ifdef QUARTUS
+    for (genvar i = 0; i < LANES; i++) begin
         acl_fsqrt fsqrt (
             .clk    (clk),
             .areset (reset),
@@ -36,16 +36,22 @@ module VX_fp_sqrt #(
             .a      (dataa[i]),
             .q      (result[i])
         );
+    end
     `else
+        // one call per cycle for the whole warp
         integer fsqrt_h;
+        int dataa_l [LANES], result_l [LANES];
         initial begin
             fsqrt_h = dpi_register();
         end
+        for (genvar i = 0; i < LANES; i++) begin
+            assign dataa_l[i] = dataa[i];
+            assign result[i] = result_l[i];
+        end
         always @(posedge clk) begin
-           dpi_fsqrt(fsqrt_h, enable, dataa[i], result[i]);
+           dpi_fsqrt(fsqrt_h, enable, valid_in, dataa_l, result_l);
         end
     `endif
-    end
 
     VX_shift_register #(
         .DATAW(TAGW + 1),
@@ -1,6 +1,6 @@
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
-#include <unordered_map>
 #include <vector>
 #include <mutex>
 #include <iostream>
@@ -8,54 +8,63 @@
 #include "verilated_vpi.h"
 #include "VX_config.h"
 
+// Whole-warp models of the FPU cores for RTL simulation. Each call takes
+// every lane of the core as an open array, evaluates only the operation
+// selected at the input, and only when the input is valid.
+
 extern "C" {
   int dpi_register();
-  void dpi_fadd(int inst, bool enable, int a, int b, int* result);
-  void dpi_fsub(int inst, bool enable, int a, int b, int* result);
-  void dpi_fmul(int inst, bool enable, int a, int b, int* result);
-  void dpi_fmadd(int inst, bool enable, int a, int b, int c, int* result);
-  void dpi_fmsub(int inst, bool enable, int a, int b, int c, int* result);
-  void dpi_fdiv(int inst, bool enable, int a, int b, int* result);
-  void dpi_fsqrt(int inst, bool enable, int a, int* result);
-  void dpi_ftoi(int inst, bool enable, int a, int* result);
-  void dpi_ftou(int inst, bool enable, int a, int* result);
-  void dpi_itof(int inst, bool enable, int a, int* result);
-  void dpi_utof(int inst, bool enable, int a, int* result);
+  void dpi_faddmul(int inst, bool enable, bool valid, bool do_sub, bool do_mul, const svOpenArrayHandle a, const svOpenArrayHandle b, const svOpenArrayHandle result);
+  void dpi_fmadd(int inst, bool enable, bool valid, bool do_sub, const svOpenArrayHandle a, const svOpenArrayHandle b, const svOpenArrayHandle c, const svOpenArrayHandle result);
+  void dpi_fdiv(int inst, bool enable, bool valid, const svOpenArrayHandle a, const svOpenArrayHandle b, const svOpenArrayHandle result);
+  void dpi_fsqrt(int inst, bool enable, bool valid, const svOpenArrayHandle a, const svOpenArrayHandle result);
+  void dpi_ftoi(int inst, bool enable, bool valid, bool is_signed, const svOpenArrayHandle a, const svOpenArrayHandle result);
+  void dpi_itof(int inst, bool enable, bool valid, bool is_signed, const svOpenArrayHandle a, const svOpenArrayHandle result);
 }
 
-class ShiftRegister {
+// Fixed-latency pipe of whole-warp results: a ring of depth slots of lanes
+// words. A push writes the slot that is retiring and advances the head, so
+// the oldest result is always at the head and nothing is shifted.
+class Pipe {
 public:
-  ShiftRegister() : init_(false), depth_(0) {}
+  Pipe() : depth_(0), lanes_(0), head_(0) {}
 
-  void ensure_init(int depth) {
-    if (!init_) {
-      buffer_.resize(depth);
-      init_  = true;
+  void ensure_init(unsigned depth, unsigned lanes) {
+    if (depth_ == 0) {
+      buffer_.resize(depth * lanes);
       depth_ = depth;
+      lanes_ = lanes;
     }
   }
 
-  void push(int value, bool enable) {
-    if (!enable)
-      return;      
-    for (unsigned i = 0; i < depth_-1; ++i) {
-      buffer_[i] = buffer_[i+1];
-    }
-    buffer_[depth_-1] = value;
+  // slot receiving this cycle's results
+  int* tail() {
+    return &buffer_[head_ * lanes_];
+  }
+
+  void advance() {
+    if (++head_ == depth_)
+      head_ = 0;
+  }
+
+  // results entered depth-1 pushes ago
+  const int* top() const {
+    return &buffer_[head_ * lanes_];
   }
 
-  int top() const {
-    return buffer_[0];
+  unsigned lanes() const {
+    return lanes_;
   }
 
 private:
 
   std::vector<int> buffer_;
-  bool init_;
-  unsigned depth_;  
+  unsigned depth_;
+  unsigned lanes_;
+  unsigned head_;
 };
 
-union Float_t {    
+union Float_t {
     float f;
     int   i;
     struct {
@@ -63,179 +72,134 @@ union Float_t {
         uint32_t exp  : 8;
         uint32_t sign : 1;
     } parts;
-}; 
+};
 
 class Instances {
 public:
-  ShiftRegister& get(int inst) {
-    return instances_.at(inst);
+  // handles come from dpi_register(), so the lookup is unchecked
+  Pipe& get(int inst) {
+    return instances_[inst];
   }
 
   int allocate() {
-    mutex_.lock();   
+    mutex_.lock();
     int inst = instances_.size();
-    instances_.resize(inst + 1); 
+    instances_.resize(inst + 1);
     mutex_.unlock();
     return inst;
   }
 
 private:
-  std::vector<ShiftRegister> instances_;
+  std::vector<Pipe> instances_;
   std::mutex mutex_;
 };
 
 Instances instances;
 
-int dpi_register() {
-  return instances.allocate();
-}
-
-void dpi_fadd(int inst, bool enable, int a, int b, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fb, fr;
+namespace {
 
-  fa.i = a;
-  fb.i = b;
-  fr.f = fa.f + fb.f;
-
-  sr.ensure_init(LATENCY_FADDMUL);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+inline float as_float(int i) {
+  Float_t x;
+  x.i = i;
+  return x.f;
 }
 
-void dpi_fsub(int inst, bool enable, int a, int b, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fb, fr;
-
-  fa.i = a;
-  fb.i = b;
-  fr.f = fa.f - fb.f;
-
-  sr.ensure_init(LATENCY_FADDMUL);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+inline int as_int(float f) {
+  Float_t x;
+  x.f = f;
+  return x.i;
 }
 
-void dpi_fmul(int inst, bool enable, int a, int b, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fb, fr;
-
-  fa.i = a;
-  fb.i = b;
-  fr.f = fa.f * fb.f;
-
-  sr.ensure_init(LATENCY_FADDMUL);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+inline const int* lanes_of(const svOpenArrayHandle h) {
+  return (const int*)svGetArrayPtr(h);
 }
 
-void dpi_fmadd(int inst, bool enable, int a, int b, int c, int* result) {
-  ShiftRegister& sr = instances.get(inst);
+// Advance the pipe on enable, with op() filling the new slot when the input
+// is valid, and drive result with the retiring slot. While stalled the
+// result array already holds the head slot.
+template <typename Op>
+void step(int inst, unsigned latency, bool enable, bool valid,
+          const svOpenArrayHandle a, const svOpenArrayHandle result, Op op) {
+  if (!enable)
+    return;
 
-  Float_t fa, fb, fc, fr;
+  Pipe& pipe = instances.get(inst);
+  pipe.ensure_init(latency, svSize(a, 1));
 
-  fa.i = a;
-  fb.i = b;
-  fc.i = c;
-  fr.f = fa.f * fb.f + fc.f;
+  if (valid) {
+    op(pipe.tail(), pipe.lanes());
+  }
+  pipe.advance();
 
-  sr.ensure_init(LATENCY_FMADD);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+  memcpy(svGetArrayPtr(result), pipe.top(), pipe.lanes() * sizeof(int));
 }
 
-void dpi_fmsub(int inst, bool enable, int a, int b, int c, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fb, fc, fr;
-
-  fa.i = a;
-  fb.i = b;
-  fc.i = c;
-  fr.f = fa.f * fb.f - fc.f;
-
-  sr.ensure_init(LATENCY_FMADD);
-  sr.push(fr.i, enable);
-  *result = sr.top();
 }
 
-void dpi_fdiv(int inst, bool enable, int a, int b, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fb, fr;
-
-  fa.i = a;
-  fb.i = b;
-  fr.f = fa.f / fb.f;
-
-  sr.ensure_init(LATENCY_FDIV);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+int dpi_register() {
+  return instances.allocate();
 }
 
-void dpi_fsqrt(int inst, bool enable, int a, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fr;
-
-  fa.i = a;
-  fr.f = sqrtf(fa.f);
-
-  sr.ensure_init(LATENCY_FSQRT);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+void dpi_faddmul(int inst, bool enable, bool valid, bool do_sub, bool do_mul, const svOpenArrayHandle a, const svOpenArrayHandle b, const svOpenArrayHandle result) {
+  const int* pa = lanes_of(a);
+  const int* pb = lanes_of(b);
+  step(inst, LATENCY_FADDMUL, enable, valid, a, result, [&](int* r, unsigned n) {
+    if (do_mul) {
+      for (unsigned i = 0; i < n; ++i) r[i] = as_int(as_float(pa[i]) * as_float(pb[i]));
+    } else if (do_sub) {
+      for (unsigned i = 0; i < n; ++i) r[i] = as_int(as_float(pa[i]) - as_float(pb[i]));
+    } else {
+      for (unsigned i = 0; i < n; ++i) r[i] = as_int(as_float(pa[i]) + as_float(pb[i]));
+    }
+  });
 }
 
-void dpi_ftoi(int inst, bool enable, int a, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fr;
-
-  fa.i = a;
-  fr.i = int(fa.f);   
-
-  sr.ensure_init(LATENCY_FTOI);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+void dpi_fmadd(int inst, bool enable, bool valid, bool do_sub, const svOpenArrayHandle a, const svOpenArrayHandle b, const svOpenArrayHandle c, const svOpenArrayHandle result) {
+  const int* pa = lanes_of(a);
+  const int* pb = lanes_of(b);
+  const int* pc = lanes_of(c);
+  step(inst, LATENCY_FMADD, enable, valid, a, result, [&](int* r, unsigned n) {
+    if (do_sub) {
+      for (unsigned i = 0; i < n; ++i) r[i] = as_int(as_float(pa[i]) * as_float(pb[i]) - as_float(pc[i]));
+    } else {
+      for (unsigned i = 0; i < n; ++i) r[i] = as_int(as_float(pa[i]) * as_float(pb[i]) + as_float(pc[i]));
+    }
+  });
 }
 
-void dpi_ftou(int inst, bool enable, int a, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fr;
-
-  fa.i = a;
-  fr.i = unsigned(fa.f);   
-
-  sr.ensure_init(LATENCY_FTOI);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+void dpi_fdiv(int inst, bool enable, bool valid, const svOpenArrayHandle a, const svOpenArrayHandle b, const svOpenArrayHandle result) {
+  const int* pa = lanes_of(a);
+  const int* pb = lanes_of(b);
+  step(inst, LATENCY_FDIV, enable, valid, a, result, [&](int* r, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) r[i] = as_int(as_float(pa[i]) / as_float(pb[i]));
+  });
 }
 
-void dpi_itof(int inst, bool enable, int a, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fr;
-
-  fr.f = (float)a;   
-
-  sr.ensure_init(LATENCY_ITOF);
-  sr.push(fr.i, enable);
-  *result = sr.top();
+void dpi_fsqrt(int inst, bool enable, bool valid, const svOpenArrayHandle a, const svOpenArrayHandle result) {
+  const int* pa = lanes_of(a);
+  step(inst, LATENCY_FSQRT, enable, valid, a, result, [&](int* r, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) r[i] = as_int(sqrtf(as_float(pa[i])));
+  });
 }
 
-void dpi_utof(int inst, bool enable, int a, int* result) {
-  ShiftRegister& sr = instances.get(inst);
-
-  Float_t fa, fr;
-
-  unsigned ua = a;
-  fr.f = (float)ua;   
+void dpi_ftoi(int inst, bool enable, bool valid, bool is_signed, const svOpenArrayHandle a, const svOpenArrayHandle result) {
+  const int* pa = lanes_of(a);
+  step(inst, LATENCY_FTOI, enable, valid, a, result, [&](int* r, unsigned n) {
+    if (is_signed) {
+      for (unsigned i = 0; i < n; ++i) r[i] = int(as_float(pa[i]));
+    } else {
+      for (unsigned i = 0; i < n; ++i) r[i] = unsigned(as_float(pa[i]));
+    }
+  });
+}
 
-  sr.ensure_init(LATENCY_ITOF);
-  sr.push(fr.i, enable);
-  *result = sr.top();
-}
\ No newline at end of file
+void dpi_itof(int inst, bool enable, bool valid, bool is_signed, const svOpenArrayHandle a, const svOpenArrayHandle result) {
+  const int* pa = lanes_of(a);
+  step(inst, LATENCY_ITOF, enable, valid, a, result, [&](int* r, unsigned n) {
+    if (is_signed) {
+      for (unsigned i = 0; i < n; ++i) r[i] = as_int((float)pa[i]);
+    } else {
+      for (unsigned i = 0; i < n; ++i) r[i] = as_int((float)(unsigned)pa[i]);
+    }
+  });
+}
@@ -3,16 +3,12 @@
 
 import "DPI-C" context function int dpi_register();
 
-import "DPI-C" context function void dpi_fadd(int inst, input logic enable, input int a, input int b, output int result);
-import "DPI-C" context function void dpi_fsub(int inst, input logic enable, input int a, input int b, output int result);
-import "DPI-C" context function void dpi_fmul(int inst, input logic enable, input int a, input int b, output int result);
-import "DPI-C" context function void dpi_fmadd(int inst, input logic enable, input int a, input int b, input int c, output int result);
-import "DPI-C" context function void dpi_fmsub(int inst, input logic enable, input int a, input int b, input int c, output int result);
-import "DPI-C" context function void dpi_fdiv(int inst, input logic enable, input int a, input int b, output int result);
-import "DPI-C" context function void dpi_fsqrt(int inst, input logic enable, input int a, output int result);
-import "DPI-C" context function void dpi_ftoi(int inst, input logic enable, input int a, output int result);
-import "DPI-C" context function void dpi_ftou(int inst, input logic enable, input int a, output int result);
-import "DPI-C" context function void dpi_itof(int inst, input logic enable, input int a, output int result);
-import "DPI-C" context function void dpi_utof(int inst, input logic enable, input int a, output int result);
+// Whole-warp entry points: one call per core per cycle, lanes as open arrays
+import "DPI-C" context function void dpi_faddmul(int inst, input logic enable, input logic valid, input logic do_sub, input logic do_mul, input int a[], input int b[], output int result[]);
+import "DPI-C" context function void dpi_fmadd(int inst, input logic enable, input logic valid, input logic do_sub, input int a[], input int b[], input int c[], output int result[]);
+import "DPI-C" context function void dpi_fdiv(int inst, input logic enable, input logic valid, input int a[], input int b[], output int result[]);
+import "DPI-C" context function void dpi_fsqrt(int inst, input logic enable, input logic valid, input int a[], output int result[]);
+import "DPI-C" context function void dpi_ftoi(int inst, input logic enable, input logic valid, input logic is_signed, input int a[], output int result[]);
+import "DPI-C" context function void dpi_itof(int inst, input logic enable, input logic valid, input logic is_signed, input int a[], output int result[]);
 
-`endif
\ No newline at end of file
+`endif
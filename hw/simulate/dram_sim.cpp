@@ -0,0 +1,122 @@
+#include "dram_sim.h"
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+
+bool DramConfig::parse(const std::string& spec) {
+  auto colon = spec.find(':');
+  auto mode = spec.substr(0, colon);
+  if (mode == "fixed") {
+    banked = false;
+  } else if (mode == "banked") {
+    banked = true;
+    stall_modulo = 0;
+  } else {
+    return false;
+  }
+  if (colon == std::string::npos)
+    return true;
+
+  std::stringstream ss(spec.substr(colon + 1));
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    auto eq = item.find('=');
+    if (eq == std::string::npos)
+      return false;
+    auto key = item.substr(0, eq);
+    char* end;
+    unsigned value = strtoul(item.c_str() + eq + 1, &end, 0);
+    if (*end != '\0')
+      return false;
+    if (key == "latency")           latency = value;
+    else if (key == "queue_size")   queue_size = value;
+    else if (key == "stall_modulo") stall_modulo = value;
+    else if (key == "block_size")   block_size = value;
+    else if (key == "banks")        banks = value;
+    else if (key == "row_size")     row_size = value;
+    else if (key == "t_rcd")        t_rcd = value;
+    else if (key == "t_cas")        t_cas = value;
+    else if (key == "t_rp")         t_rp = value;
+    else if (key == "bus_width")    bus_width = value;
+    else return false;
+  }
+  return (banks != 0 && row_size != 0 && bus_width != 0);
+}
+
+void DramConfig::from_env() {
+  auto spec = getenv("VX_DRAM");
+  auto defaults = *this;
+  if (spec && !this->parse(spec)) {
+    std::cerr << "Warning: invalid VX_DRAM=" << spec << ", using defaults" << std::endl;
+    *this = defaults;
+  }
+}
+
+DramSim::DramSim(const DramConfig& config) : config_(config) {
+  this->reset();
+  reads_ = 0;
+  writes_ = 0;
+  row_hits_ = 0;
+  row_misses_ = 0;
+  row_conflicts_ = 0;
+  read_latency_ = 0;
+}
+
+void DramSim::reset() {
+  banks_.assign(config_.banks, bank_t{-1, 0});
+  bus_free_ = 0;
+}
+
+uint64_t DramSim::access(uint64_t addr, bool write, uint64_t now) {
+  if (write) {
+    ++writes_;
+  } else {
+    ++reads_;
+  }
+
+  if (!config_.banked) {
+    if (write)
+      return now;
+    read_latency_ += config_.latency;
+    return now + config_.latency;
+  }
+
+  uint64_t row_index = addr / config_.row_size;
+  auto& bank = banks_[row_index % config_.banks];
+  int64_t row = row_index / config_.banks;
+
+  uint64_t start = std::max(now, bank.ready);
+  uint64_t command;
+  if (bank.open_row == row) {
+    ++row_hits_;
+    command = config_.t_cas;
+  } else if (bank.open_row < 0) {
+    ++row_misses_;
+    command = config_.t_rcd + config_.t_cas;
+  } else {
+    ++row_conflicts_;
+    command = config_.t_rp + config_.t_rcd + config_.t_cas;
+  }
+  bank.open_row = row;
+
+  uint64_t burst = (config_.block_size + config_.bus_width - 1) / config_.bus_width;
+  uint64_t data = std::max(start + command, bus_free_);
+  uint64_t done = data + burst;
+  bus_free_ = done;
+  bank.ready = data;
+
+  if (!write) {
+    read_latency_ += done - now;
+  }
+  return done;
+}
+
+void DramSim::print_stats(std::ostream& out) const {
+  out << "mode=" << (config_.banked ? "banked" : "fixed")
+      << ", reads=" << reads_ << ", writes=" << writes_;
+  if (config_.banked) {
+    out << ", row_hits=" << row_hits_ << ", row_misses=" << row_misses_
+        << ", row_conflicts=" << row_conflicts_;
+  }
+  out << ", avg_read_latency=" << (reads_ ? double(read_latency_) / reads_ : 0.0);
+}
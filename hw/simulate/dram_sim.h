@@ -0,0 +1,172 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+
+// DRAM timing shared by rtlsim, vlsim and the cache unit tests.
+// "fixed" mode reproduces the original bus models: a constant latency, a
+// bounded request queue and a periodic artificial stall. "banked" mode adds
+// per-bank row buffers (tRCD/tCAS/tRP) and a data bus of bus_width bytes
+// per cycle. Completion is computed when a request is issued, so the clients
+// keep pending reads in a completion-ordered heap instead of counting down
+// every entry every cycle. All times are in simulator cycles.
+struct DramConfig {
+  DramConfig()
+    : banked(false)
+    , latency(4)
+    , queue_size(16)
+    , stall_modulo(16)
+    , block_size(64)
+    , banks(8)
+    , row_size(2048)
+    , t_rcd(10)
+    , t_cas(10)
+    , t_rp(10)
+    , bus_width(16)
+  {}
+
+  bool     banked;
+  unsigned latency;       // fixed mode read latency
+  unsigned queue_size;    // outstanding reads before the bus stalls
+  unsigned stall_modulo;  // stall one cycle in every stall_modulo, 0 = never
+  unsigned block_size;    // bytes per request
+  unsigned banks;
+  unsigned row_size;      // bytes per row
+  unsigned t_rcd, t_cas, t_rp;
+  unsigned bus_width;     // bytes per cycle on the data bus
+
+  // "fixed" or "banked", optionally followed by ":key=value,...". Keys are
+  // the field names above. Returns false on a malformed spec.
+  bool parse(const std::string& spec);
+
+  // apply the VX_DRAM environment variable, if set
+  void from_env();
+};
+
+class DramSim {
+public:
+
+  DramSim(const DramConfig& config);
+
+  const DramConfig& config() const {
+    return config_;
+  }
+
+  // close all rows and idle the bus; the statistics are kept
+  void reset();
+
+  // whether a request can be accepted this cycle with `pending` reads in
+  // flight
+  bool ready(uint64_t now, size_t pending) const {
+    if (config_.stall_modulo && 0 == (now % config_.stall_modulo))
+      return false;
+    return pending < config_.queue_size;
+  }
+
+  // issue an access to byte address addr; returns its completion cycle
+  uint64_t access(uint64_t addr, bool write, uint64_t now);
+
+  void print_stats(std::ostream& out) const;
+
+private:
+
+  struct bank_t {
+    int64_t  open_row;   // -1 when precharged
+    uint64_t ready;      // first cycle the bank takes a new command
+  };
+
+  DramConfig config_;
+  std::vector<bank_t> banks_;
+  uint64_t bus_free_;
+
+  uint64_t reads_;
+  uint64_t writes_;
+  uint64_t row_hits_;
+  uint64_t row_misses_;
+  uint64_t row_conflicts_;
+  uint64_t read_latency_;
+};
+
+// Pending reads of a bus model, ordered by completion cycle and by issue
+// order among equals. With in_order set (Avalon, which returns read data
+// without a tag) a read never completes before an earlier one.
+template <typename T>
+class DramQueue {
+public:
+
+  DramQueue(const DramConfig& config, bool in_order = false)
+    : dram_(config)
+    , in_order_(in_order)
+    , seq_(0)
+    , last_done_(0)
+  {}
+
+  DramSim& dram() {
+    return dram_;
+  }
+
+  const DramSim& dram() const {
+    return dram_;
+  }
+
+  bool ready(uint64_t now) const {
+    return dram_.ready(now, heap_.size());
+  }
+
+  size_t size() const {
+    return heap_.size();
+  }
+
+  void clear() {
+    heap_.clear();
+    dram_.reset();
+    last_done_ = 0;
+  }
+
+  void write(uint64_t addr, uint64_t now) {
+    dram_.access(addr, true, now);
+  }
+
+  void read(uint64_t addr, uint64_t now, const T& data) {
+    uint64_t done = dram_.access(addr, false, now);
+    if (in_order_) {
+      done = std::max(done, last_done_);
+      last_done_ = done;
+    }
+    heap_.push_back(entry_t{done, seq_++, data});
+    std::push_heap(heap_.begin(), heap_.end(), later);
+  }
+
+  // earliest read completed by now, or nullptr
+  const T* front(uint64_t now) const {
+    if (heap_.empty() || heap_.front().done > now)
+      return nullptr;
+    return &heap_.front().data;
+  }
+
+  void pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    heap_.pop_back();
+  }
+
+private:
+
+  struct entry_t {
+    uint64_t done;
+    uint64_t seq;
+    T data;
+  };
+
+  static bool later(const entry_t& a, const entry_t& b) {
+    return (a.done != b.done) ? (a.done > b.done) : (a.seq > b.seq);
+  }
+
+  DramSim dram_;
+  bool in_order_;
+  uint64_t seq_;
+  uint64_t last_done_;
+  std::vector<entry_t> heap_;
+};
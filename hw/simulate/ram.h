@@ -2,63 +2,71 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <stdexcept>
 
+// Flat 4 GB device memory shared by simX and the RTL simulators.
+// The whole address space is reserved up front with mmap and the OS commits
+// (zero-filled) pages on first touch, so any address maps to base() + address
+// and bulk transfers are plain memcpy.
 class RAM {
 private:
 
-  mutable uint8_t *mem_[(1 << 12)];      
-
-  uint8_t *get(uint32_t address) const {
-    uint32_t block_addr   = address >> 20;
-    uint32_t block_offset = address & 0x000FFFFF;
-    if (mem_[block_addr] == NULL) {
-      mem_[block_addr] = new uint8_t[(1 << 20)];
-    }
-    return mem_[block_addr] + block_offset;
-  }
+  uint8_t *mem_;
 
 public:
 
   RAM() {
-    for (uint32_t i = 0; i < (1 << 12); i++) {
-      mem_[i] = NULL;
-    }
+    void *ptr = mmap(NULL, this->size(), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED)
+      throw std::runtime_error("RAM: failed to reserve device memory");
+    mem_ = (uint8_t*)ptr;
   }
 
   ~RAM() {
-    this->clear();
+    munmap(mem_, this->size());
   }
 
+  RAM(const RAM&) = delete;
+  RAM& operator=(const RAM&) = delete;
+
   size_t size() const {
     return (1ull << 32);
   }
 
+  // release all committed pages; memory reads back as zero afterwards
   void clear() {
-    for (uint32_t i = 0; i < (1 << 12); i++) {
-      if (mem_[i]) {
-        delete [] mem_[i];
-        mem_[i] = NULL;
-      }
-    }
+    madvise(mem_, this->size(), MADV_DONTNEED);
+  }
+
+  // direct pointer for zero-copy access
+  uint8_t *get(uint32_t address) const {
+    return mem_ + address;
+  }
+
+  uint8_t *base() const {
+    return mem_;
   }
 
   void read(uint32_t address, uint32_t length, uint8_t *data) const {
-    for (unsigned i = 0; i < length; i++) {
-      data[i] = *this->get(address + i);
-    }
+    if ((uint64_t)address + length > this->size())
+      throw std::out_of_range("RAM: read out of range");
+    memcpy(data, mem_ + address, length);
   }
 
   void write(uint32_t address, uint32_t length, const uint8_t *data) {
-    for (unsigned i = 0; i < length; i++) {
-      *this->get(address + i) = data[i];
-    }
+    if ((uint64_t)address + length > this->size())
+      throw std::out_of_range("RAM: write out of range");
+    memcpy(mem_ + address, data, length);
   }
 
   uint8_t& operator[](uint32_t address) {
-    return *get(address);
+    return mem_[address];
   }
 
   const uint8_t& operator[](uint32_t address) const {
-    return *get(address);
+    return mem_[address];
   }
-};
\ No newline at end of file
+};
@@ -2,11 +2,9 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
-
-#define ENABLE_DRAM_STALLS
-#define DRAM_LATENCY 4
-#define DRAM_RQ_SIZE 16
-#define DRAM_STALLS_MODULO 16
+#ifdef SIM_AFFINITY
+#include <sched.h>
+#endif
 
 #define VL_WDATA_GETW(lwp, i, n, w) \
   VL_SEL_IWII(0, n * w, 0, 0, lwp, i * w, w)
@@ -17,7 +15,14 @@ double sc_time_stamp() {
   return timestamp;
 }
 
-Simulator::Simulator() {  
+static DramConfig dram_config() {
+  DramConfig config;
+  config.block_size = GLOBAL_BLOCK_SIZE;
+  config.from_env();
+  return config;
+}
+
+Simulator::Simulator() : dram_queue_(dram_config()) {  
   // force random values for unitialized signals  
   Verilated::randReset(2);
   Verilated::randSeed(50);
@@ -25,14 +30,41 @@ Simulator::Simulator() {
   // Turn off assertion before reset
   Verilated::assertOn(false);
 
+#ifdef SIM_AFFINITY
+  // the model's worker threads inherit the mask of the thread creating it,
+  // so pin this thread while they are spawned and restore it afterwards
+  cpu_set_t host_cpus, cpus;
+  bool pinned = (sched_getaffinity(0, sizeof(host_cpus), &host_cpus) == 0);
+  CPU_ZERO(&cpus);
+  for (int i = 0; i < SIM_THREADS; ++i) {
+    CPU_SET(SIM_AFFINITY + i, &cpus);
+  }
+  if (!pinned || sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+    pinned = false;
+    std::cout << "warning: cannot pin the simulator to CPUs " << SIM_AFFINITY 
+              << "-" << (SIM_AFFINITY + SIM_THREADS - 1) << std::endl;
+  }
+#endif
+
   ram_ = nullptr;
-  vortex_ = new VVortex();
+  vortex_ = new VVortex(); // creates the Verilator thread pool
+
+#ifdef SIM_AFFINITY
+  if (pinned) {
+    sched_setaffinity(0, sizeof(host_cpus), &host_cpus);
+  }
+#endif
 
 #ifdef VCD_OUTPUT
   Verilated::traceEverOn(true);
   trace_ = new VerilatedFstC();
   vortex_->trace(trace_, 99);
-  trace_->open("trace.fst");
+  trace_ctl_.attach(trace_, "trace.fst");
+  {
+    TraceConfig config;
+    config.from_env();
+    trace_ctl_.configure(config, this->signal_probe(config.signal));
+  }
 #endif  
 
   // reset the device
@@ -47,14 +79,14 @@ Simulator::~Simulator() {
     }
   }
 #ifdef VCD_OUTPUT
-  trace_->close();
+  trace_ctl_.close();
 #endif
   delete vortex_;
 }
 
 void Simulator::attach_ram(RAM* ram) {
   ram_ = ram;
-  dram_rsp_vec_.clear();
+  dram_queue_.clear();
 }
 
 void Simulator::reset() {     
@@ -63,7 +95,7 @@ void Simulator::reset() {
 #endif
 
   print_bufs_.clear();
-  dram_rsp_vec_.clear();
+  dram_queue_.clear();
 
   dram_rsp_active_ = false;
   snp_req_active_ = false;
@@ -110,7 +142,7 @@ void Simulator::step() {
 void Simulator::eval() {
   vortex_->eval();
 #ifdef VCD_OUTPUT
-  trace_->dump(timestamp);
+  trace_ctl_.dump(timestamp);
 #endif
   ++timestamp;
 }
@@ -121,16 +153,7 @@ void Simulator::eval_dram_bus() {
     return;
   }
 
-  // schedule DRAM responses
-  std::list<dram_req_t>::iterator dram_rsp_it(dram_rsp_vec_.end());
-  for (auto it = dram_rsp_vec_.begin(), ie = dram_rsp_vec_.end(); it != ie; ++it) {
-    if (it->cycles_left > 0) {
-      it->cycles_left -= 1;
-    }
-    if ((dram_rsp_it == ie) && (it->cycles_left == 0)) {
-      dram_rsp_it = it;
-    }
-  }
+  uint64_t cycle = timestamp / 2;
 
   // send DRAM response  
   if (dram_rsp_active_
@@ -139,11 +162,12 @@ void Simulator::eval_dram_bus() {
     dram_rsp_active_ = false;
   }
   if (!dram_rsp_active_) {
-    if (dram_rsp_it != dram_rsp_vec_.end()) {
+    auto dram_rsp = dram_queue_.front(cycle);
+    if (dram_rsp) {
       vortex_->dram_rsp_valid = 1;
-      memcpy((uint8_t*)vortex_->dram_rsp_data, dram_rsp_it->block.data(), GLOBAL_BLOCK_SIZE);
-      vortex_->dram_rsp_tag = dram_rsp_it->tag;   
-      dram_rsp_vec_.erase(dram_rsp_it);
+      memcpy((uint8_t*)vortex_->dram_rsp_data, dram_rsp->block.data(), GLOBAL_BLOCK_SIZE);
+      vortex_->dram_rsp_tag = dram_rsp->tag;   
+      dram_queue_.pop();
       dram_rsp_active_ = true;
     } else {
       vortex_->dram_rsp_valid = 0;
@@ -151,34 +175,26 @@ void Simulator::eval_dram_bus() {
   }
 
   // handle DRAM stalls
-  bool dram_stalled = false;
-#ifdef ENABLE_DRAM_STALLS
-  if (0 == ((timestamp/2) % DRAM_STALLS_MODULO)) { 
-    dram_stalled = true;
-  } else
-  if (dram_rsp_vec_.size() >= DRAM_RQ_SIZE) {
-    dram_stalled = true;
-  }
-#endif
+  bool dram_stalled = !dram_queue_.ready(cycle);
 
   // process DRAM requests
   if (!dram_stalled) {
     if (vortex_->dram_req_valid) {
+      unsigned base_addr = (vortex_->dram_req_addr * GLOBAL_BLOCK_SIZE);
       if (vortex_->dram_req_rw) {
         uint64_t byteen = vortex_->dram_req_byteen;
-        unsigned base_addr = (vortex_->dram_req_addr * GLOBAL_BLOCK_SIZE);
         uint8_t* data = (uint8_t*)(vortex_->dram_req_data);
         for (int i = 0; i < GLOBAL_BLOCK_SIZE; i++) {
           if ((byteen >> i) & 0x1) {            
             (*ram_)[base_addr + i] = data[i];
           }
         }
+        dram_queue_.write(base_addr, cycle);
       } else {
         dram_req_t dram_req;
-        dram_req.cycles_left = DRAM_LATENCY;     
         dram_req.tag = vortex_->dram_req_tag;
-        ram_->read(vortex_->dram_req_addr * GLOBAL_BLOCK_SIZE, GLOBAL_BLOCK_SIZE, dram_req.block.data());
-        dram_rsp_vec_.emplace_back(dram_req);
+        ram_->read(base_addr, GLOBAL_BLOCK_SIZE, dram_req.block.data());
+        dram_queue_.read(base_addr, cycle, dram_req);
       } 
     }    
   }
@@ -330,7 +346,7 @@ void Simulator::get_csr(int core_id, int addr, unsigned *value) {
   csr_req_active_ = true;  
 }
 
-void Simulator::run() {
+bool Simulator::run(uint64_t max_cycles) {
 #ifndef NDEBUG
   std::cout << timestamp << ": [sim] run()" << std::endl;
 #endif
@@ -338,11 +354,18 @@ void Simulator::run() {
   // execute program
   while (vortex_->busy 
       && !vortex_->ebreak) {
+    if (max_cycles && this->cycles() >= max_cycles)
+      return false;
     this->step();
   }
 
   // wait 5 cycles to flush the pipeline
   this->wait(5);  
+  return true;
+}
+
+uint64_t Simulator::cycles() const {
+  return timestamp / 2;
 }
 
 int Simulator::get_last_wb_value(int reg) const {
@@ -440,4 +463,31 @@ void Simulator::load_ihex(const char* program_file) {
 void Simulator::print_stats(std::ostream& out) {
   out << std::left;
   out << std::setw(24) << "# of total cycles:" << std::dec << timestamp/2 << std::endl;
-}
\ No newline at end of file
+  out << std::setw(24) << "# dram:";
+  dram_queue_.dram().print_stats(out);
+  out << std::endl;
+}
+
+bool Simulator::set_trace(const std::string& spec) {
+#ifdef VCD_OUTPUT
+  TraceConfig config;
+  if (!config.parse(spec))
+    return false;
+  return trace_ctl_.configure(config, this->signal_probe(config.signal));
+#else
+  (void)spec;
+  return false;
+#endif
+}
+
+#ifdef VCD_OUTPUT
+std::function<bool()> Simulator::signal_probe(const std::string& name) {
+  if (name == "ebreak")           return [this]() { return vortex_->ebreak != 0; };
+  if (name == "dram_req_valid")   return [this]() { return vortex_->dram_req_valid != 0; };
+  if (name == "dram_rsp_valid")   return [this]() { return vortex_->dram_rsp_valid != 0; };
+  if (name == "io_req_valid")     return [this]() { return vortex_->io_req_valid != 0; };
+  if (name == "snp_req_valid")    return [this]() { return vortex_->snp_req_valid != 0; };
+  if (name == "csr_io_req_valid") return [this]() { return vortex_->csr_io_req_valid != 0; };
+  return nullptr;
+}
+#endif
@@ -10,6 +10,8 @@
 
 #include <VX_config.h>
 #include "ram.h"
+#include "dram_sim.h"
+#include "trace_ctl.h"
 
 #include <ostream>
 #include <list>
@@ -17,6 +19,12 @@
 #include <sstream> 
 #include <unordered_map>
 
+// host threads of the Verilated model, set with -DSIM_THREADS=<n> when it is
+// built with --threads <n>; -DSIM_AFFINITY=<cpu> pins them to CPUs cpu..cpu+n-1
+#ifndef SIM_THREADS
+#define SIM_THREADS 1
+#endif
+
 class Simulator {
 public:
   
@@ -41,15 +49,26 @@ public:
   void set_csr(int core_id, int addr, unsigned value);
   void get_csr(int core_id, int addr, unsigned *value);
 
-  void run();  
+  // run until ebreak or idle; false if max_cycles (0 = no limit) ran out first
+  bool run(uint64_t max_cycles = 0);
+
+  uint64_t cycles() const;
+
   int get_last_wb_value(int reg) const;  
 
   void print_stats(std::ostream& out);
 
+  // limit waveform capture (see trace_ctl.h); false if the spec is invalid
+  // or this is not a VCD_OUTPUT build
+  bool set_trace(const std::string& spec);
+
+  const DramSim& dram() const {
+    return dram_queue_.dram();
+  }
+
 private:  
 
   typedef struct {
-    int cycles_left;  
     std::array<uint8_t, GLOBAL_BLOCK_SIZE> block;
     unsigned tag;
   } dram_req_t;
@@ -63,7 +82,7 @@ private:
   void eval_csr_bus();
   void eval_snp_bus();
   
-  std::list<dram_req_t> dram_rsp_vec_;
+  DramQueue<dram_req_t> dram_queue_;
   bool dram_rsp_active_;
   
   bool snp_req_active_;
@@ -76,6 +95,8 @@ private:
   RAM *ram_;
   VVortex *vortex_;
 #ifdef VCD_OUTPUT
+  std::function<bool()> signal_probe(const std::string& name);
   VerilatedFstC *trace_;
+  TraceControl<VerilatedFstC> trace_ctl_;
 #endif
 };
\ No newline at end of file
@@ -2,158 +2,329 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/wait.h>
 
-#define ALL_TESTS
+// Parallel RTL regression runner. Each test runs in its own forked process
+// with a fresh Simulator and RAM, up to -j at a time, and reports back over a
+// pipe. Without test files on the command line, the riscv-tests hex files of
+// the enabled extensions are picked up from the test directory.
 
-int main(int argc, char **argv) {
-	bool passed = true;
-	if (argc == 1) {
-#ifdef ALL_TESTS
-  std::string tests[] = {
-	  "../../../benchmarks/riscv_tests/isa/rv32ui-p-add.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-addi.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-and.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-andi.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-auipc.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-beq.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-bge.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-bgeu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-blt.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-bltu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-bne.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-jal.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-jalr.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-lb.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-lbu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-lh.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-lhu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-lui.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-lw.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-or.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-ori.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sb.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sh.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-simple.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sll.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-slli.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-slt.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-slti.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sltiu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sltu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sra.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-srai.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-srl.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-srli.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sub.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-sw.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-xor.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32ui-p-xori.hex",
+#define DEFAULT_TEST_DIR "../../../benchmarks/riscv_tests/isa"
+#define DEFAULT_MAX_CYCLES 1000000
+
+enum test_status_t { TEST_PASSED, TEST_FAILED, TEST_TIMEOUT, TEST_CRASHED };
+
+static const char* status_names[] = { "passed", "failed", "timeout", "crashed" };
+
+// sent by the child over its pipe
+typedef struct {
+  int      status;
+  uint64_t cycles;
+  uint64_t instrs;
+} test_result_t;
+
+typedef struct {
+  std::string   path;
+  std::string   name;
+  test_result_t result;
+  double        wall_time;
+  int           signal;
+} test_t;
+
+typedef struct {
+  pid_t  pid;
+  size_t test;
+  int    fd;
+  std::chrono::steady_clock::time_point start;
+} job_t;
+
+// riscv-tests prefixes run by default, and tests left out of the regression
+static const char* test_prefixes[] = {
+  "rv32ui-p-",
 #ifdef EXT_M_ENABLE
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-div.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-divu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-mul.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-mulh.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-mulhsu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-mulhu.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-rem.hex",
-	 	"../../../benchmarks/riscv_tests/isa/rv32um-p-remu.hex",
+  "rv32um-p-",
 #endif
-	 };
-
-	 std::string tests_fp[] = {
 #ifdef EXT_F_ENABLE
-    "../../../benchmarks/riscv_tests/isa/rv32uf-p-fadd.hex",
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-fdiv.hex",
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-fmadd.hex",		
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-fmin.hex",
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-fcmp.hex",		
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-ldst.hex",	 
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-fcvt.hex",
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-fcvt_w.hex",
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-fclass.hex",		
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-move.hex",	
-		"../../../benchmarks/riscv_tests/isa/rv32uf-p-recoding.hex",
+  "rv32uf-p-",
 #endif
-	 };
+};
+
+static const char* excluded_tests[] = {
+  "rv32ui-p-fence_i",
+};
+
+static std::string test_name(const std::string& path) {
+  auto slash = path.rfind('/');
+  auto name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+  auto dot = name.rfind('.');
+  return (dot == std::string::npos) ? name : name.substr(0, dot);
+}
+
+static std::vector<std::string> discover_tests(const std::string& dir, const char* filter) {
+  std::vector<std::string> tests;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    std::cout << "error: cannot open test directory " << dir << std::endl;
+    return tests;
+  }
+  while (auto entry = readdir(d)) {
+    std::string file(entry->d_name);
+    if (file.size() < 4 || file.compare(file.size() - 4, 4, ".hex") != 0)
+      continue;
+    auto name = test_name(file);
+    bool selected = false;
+    for (auto prefix : test_prefixes) {
+      selected |= (name.compare(0, strlen(prefix), prefix) == 0);
+    }
+    for (auto excluded : excluded_tests) {
+      selected &= (name != excluded);
+    }
+    if (filter && fnmatch(filter, name.c_str(), 0) != 0)
+      selected = false;
+    if (selected) {
+      tests.push_back(dir + "/" + file);
+    }
+  }
+  closedir(d);
+  std::sort(tests.begin(), tests.end());
+  return tests;
+}
+
+static uint64_t get_csr64(Simulator& simulator, int core_id, int addr_lo, int addr_hi) {
+  unsigned lo, hi;
+  simulator.get_csr(core_id, addr_hi, &hi);
+  while (simulator.csr_req_active()) {
+    simulator.step();
+  }
+  simulator.get_csr(core_id, addr_lo, &lo);
+  while (simulator.csr_req_active()) {
+    simulator.step();
+  }
+  return (uint64_t(hi) << 32) | lo;
+}
+
+// child side: run one test and report over fd
+static void run_test(const std::string& path, uint64_t max_cycles, int fd) {
+  test_result_t result = { TEST_FAILED, 0, 0 };
 
-	for (std::string test : tests) {
-		std::cout << DEFAULT << "\n---------------------------------------\n";
+  RAM ram;
+  Simulator simulator;
+  simulator.attach_ram(&ram);
+  simulator.load_ihex(path.c_str());
+  bool completed = simulator.run(max_cycles);
+  result.cycles = simulator.cycles();
+
+  if (!completed) {
+    result.status = TEST_TIMEOUT;
+  } else {
+    result.status = (1 == simulator.get_last_wb_value(3)) ? TEST_PASSED : TEST_FAILED;
+    for (int core_id = 0; core_id < NUM_CLUSTERS * NUM_CORES; ++core_id) {
+      result.instrs += get_csr64(simulator, core_id, CSR_INSTRET, CSR_INSTRET_H);
+    }
+  }
+
+  if (write(fd, &result, sizeof(result)) != sizeof(result)) {
+    _exit(1);
+  }
+}
 
-		std::cout << test << std::endl;
+static job_t launch(const std::vector<test_t>& tests, size_t index, uint64_t max_cycles, const char* log_dir) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    exit(1);
+  }
+
+  job_t job;
+  job.test = index;
+  job.fd = fds[0];
+  job.start = std::chrono::steady_clock::now();
+  job.pid = fork();
+  if (job.pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+
+  if (job.pid == 0) {
+    close(fds[0]);
+    // keep the simulator's output away from the runner's
+    std::string log = log_dir ? (std::string(log_dir) + "/" + tests[index].name + ".log") : "/dev/null";
+    int out = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out >= 0) {
+      dup2(out, STDOUT_FILENO);
+      dup2(out, STDERR_FILENO);
+      close(out);
+    }
+    run_test(tests[index].path, max_cycles, fds[1]);
+    close(fds[1]);
+    std::cout.flush();
+    fflush(nullptr);
+    _exit(0);
+  }
+
+  close(fds[1]);
+  return job;
+}
 
-		RAM ram;
-		Simulator simulator;
-		simulator.attach_ram(&ram);
-		simulator.load_ihex(test.c_str());
-		simulator.run();
+static double ipc(const test_result_t& result) {
+  return result.cycles ? double(result.instrs) / result.cycles : 0.0;
+}
 
-		bool status = (1 == simulator.get_last_wb_value(3));
+static void write_json(const char* filename, const std::vector<test_t>& tests) {
+  std::ofstream ofs(filename);
+  ofs << "{\"tests\": [";
+  for (size_t i = 0; i < tests.size(); ++i) {
+    auto& test = tests[i];
+    ofs << (i ? ",\n  " : "\n  ")
+        << "{\"name\": \"" << test.name << "\", \"status\": \"" << status_names[test.result.status] << "\""
+        << ", \"cycles\": " << test.result.cycles << ", \"instrs\": " << test.result.instrs
+        << ", \"ipc\": " << ipc(test.result) << ", \"wall_time\": " << test.wall_time << "}";
+  }
+  ofs << "\n]}\n";
+}
 
-		if (status) std::cout << GREEN << "Test Passed: " << test << std::endl;
-		if (!status) std::cout << RED   << "Test Failed: " << test << std::endl;
-		std::cout << DEFAULT;
-		passed = passed && status;
-		if (!passed)
-			break;
-	}
+static void write_junit(const char* filename, const std::vector<test_t>& tests, double wall_time) {
+  size_t failures = 0;
+  for (auto& test : tests) {
+    failures += (test.result.status != TEST_PASSED);
+  }
+  std::ofstream ofs(filename);
+  ofs << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<testsuite name=\"rtlsim\" tests=\"" << tests.size() << "\" failures=\"" << failures
+      << "\" time=\"" << wall_time << "\">\n";
+  for (auto& test : tests) {
+    ofs << "  <testcase classname=\"riscv_tests\" name=\"" << test.name << "\" time=\"" << test.wall_time << "\">\n";
+    if (test.result.status != TEST_PASSED) {
+      ofs << "    <failure message=\"" << status_names[test.result.status];
+      if (test.signal) {
+        ofs << " (signal " << test.signal << ")";
+      }
+      ofs << "\"/>\n";
+    }
+    ofs << "    <system-out>cycles=" << test.result.cycles << " instrs=" << test.result.instrs
+        << " ipc=" << ipc(test.result) << "</system-out>\n"
+        << "  </testcase>\n";
+  }
+  ofs << "</testsuite>\n";
+}
 
-	for (std::string test : tests_fp) {
-		std::cout << DEFAULT << "\n---------------------------------------\n";
+static void show_usage() {
+  std::cout << "Vortex RTL regression.\n"
+               "Usage: [-d test directory] [-p name pattern] [-j jobs] [-t max cycles]\n"
+               "       [-l log directory] [--json file] [--junit file] [-h: help] [test.hex ...]\n";
+}
 
-		std::cout << test << std::endl;
+int main(int argc, char **argv) {
+  std::string test_dir(DEFAULT_TEST_DIR);
+  const char* filter = nullptr;
+  const char* log_dir = nullptr;
+  const char* json_file = nullptr;
+  const char* junit_file = nullptr;
+  uint64_t max_cycles = DEFAULT_MAX_CYCLES;
+  unsigned num_jobs = std::max<long>(1, sysconf(_SC_NPROCESSORS_ONLN));
 
-		RAM ram;
-		Simulator simulator;
-		simulator.attach_ram(&ram);
-		simulator.load_ihex(test.c_str());
-		simulator.run();
+  static struct option long_options[] = {
+    {"json",  required_argument, 0, 'J'},
+    {"junit", required_argument, 0, 'U'},
+    {0, 0, 0, 0}
+  };
 
-		bool status = (1 == simulator.get_last_wb_value(3));
+  int c;
+  while ((c = getopt_long(argc, argv, "d:p:j:t:l:h?", long_options, nullptr)) != -1) {
+    switch (c) {
+    case 'd': test_dir = optarg; break;
+    case 'p': filter = optarg; break;
+    case 'j': num_jobs = std::max(1, atoi(optarg)); break;
+    case 't': max_cycles = strtoull(optarg, nullptr, 0); break;
+    case 'l': log_dir = optarg; break;
+    case 'J': json_file = optarg; break;
+    case 'U': junit_file = optarg; break;
+    default:
+      show_usage();
+      return (c == 'h') ? 0 : 1;
+    }
+  }
 
-		if (status) std::cout << GREEN << "Test Passed: " << test << std::endl;
-		if (!status) std::cout << RED   << "Test Failed: " << test << std::endl;
-		std::cout << DEFAULT;
-		passed = passed && status;
-		if (!passed)
-			break;
-	}
+  std::vector<std::string> paths(argv + optind, argv + argc);
+  if (paths.empty()) {
+    paths = discover_tests(test_dir, filter);
+  }
+  if (paths.empty()) {
+    std::cout << "error: no tests to run" << std::endl;
+    return 1;
+  }
 
-	std::cout << DEFAULT << "\n***************************************\n";
+  std::vector<test_t> tests(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    tests[i].path = paths[i];
+    tests[i].name = test_name(paths[i]);
+    tests[i].result = test_result_t{TEST_CRASHED, 0, 0};
+    tests[i].wall_time = 0;
+    tests[i].signal = 0;
+  }
 
-	if (passed) std::cout << DEFAULT << "PASSED ALL TESTS\n";
-	if (!passed) std::cout << DEFAULT << "Failed one or more tests\n";
+  std::cout << "running " << tests.size() << " tests, " << num_jobs << " jobs, "
+            << max_cycles << " cycles max" << std::endl;
 
-	return !passed;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<job_t> jobs;
+  size_t next = 0, num_passed = 0;
 
-#else
+  while (next < tests.size() || !jobs.empty()) {
+    while (next < tests.size() && jobs.size() < num_jobs) {
+      jobs.push_back(launch(tests, next++, max_cycles, log_dir));
+    }
 
-	char test[] = "../../../runtime/tests/simple/vx_simple.hex";
+    int wstatus;
+    pid_t pid = waitpid(-1, &wstatus, 0);
+    if (pid < 0) {
+      perror("waitpid");
+      return 1;
+    }
+    auto it = std::find_if(jobs.begin(), jobs.end(), [&](const job_t& job) { return job.pid == pid; });
+    if (it == jobs.end())
+      continue;
 
-  std::cout << test << std::endl;
+    auto& test = tests[it->test];
+    test.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - it->start).count();
+    test_result_t result;
+    if (read(it->fd, &result, sizeof(result)) == sizeof(result)) {
+      test.result = result;
+    }
+    if (WIFSIGNALED(wstatus)) {
+      test.signal = WTERMSIG(wstatus);
+    }
+    close(it->fd);
+    jobs.erase(it);
 
-  RAM ram;
-	Simulator simulator;
-	simulator.attach_ram(&ram);
-	simulator.load_ihex(test);
-  simulator.run();
+    bool passed = (test.result.status == TEST_PASSED);
+    num_passed += passed;
+    std::cout << (passed ? GREEN : RED) << std::left << std::setw(8) << status_names[test.result.status]
+              << DEFAULT << std::setw(24) << test.name << std::right
+              << " cycles=" << test.result.cycles << " ipc=" << std::fixed << std::setprecision(3) << ipc(test.result)
+              << " time=" << std::setprecision(2) << test.wall_time << "s" << std::endl;
+  }
 
-  return 0;
+  double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-#endif
+  if (json_file) {
+    write_json(json_file, tests);
+  }
+  if (junit_file) {
+    write_junit(junit_file, tests, wall_time);
+  }
 
-}	else {
-	std::vector<std::string> tests(argv+2, argv+argc);
-	for (std::string test : tests) {		
-		std::cout << test << std::endl;
-
-		RAM ram;
-		Simulator simulator;
-		simulator.attach_ram(&ram);
-		simulator.load_ihex(test.c_str());
-		simulator.run();
-	}
-	
-	return 0;
-}
+  std::cout << DEFAULT << "\n***************************************\n";
+  std::cout << num_passed << "/" << tests.size() << " passed in " << std::setprecision(2) << wall_time << "s" << std::endl;
+  if (num_passed == tests.size()) std::cout << "PASSED ALL TESTS\n";
+  if (num_passed != tests.size()) std::cout << "Failed one or more tests\n";
 
+  return (num_passed != tests.size());
 }
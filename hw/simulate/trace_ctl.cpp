@@ -0,0 +1,71 @@
+#include "trace_ctl.h"
+#include <stdlib.h>
+#include <atomic>
+#include <sstream>
+
+extern "C" {
+  void dpi_trace_pc(int pc);
+}
+
+namespace {
+  bool     watch_pc = false;
+  uint32_t watched_pc = 0;
+  // DPI calls may come from Verilator's worker threads
+  std::atomic<bool> pc_hit(false);
+}
+
+void dpi_trace_pc(int pc) {
+  if (watch_pc && (uint32_t)pc == watched_pc) {
+    pc_hit = true;
+  }
+}
+
+void trace_watch_pc(bool enable, uint32_t pc) {
+  watch_pc = enable;
+  watched_pc = pc;
+  pc_hit = false;
+}
+
+bool trace_pc_hit() {
+  return pc_hit.exchange(false);
+}
+
+bool TraceConfig::parse(const std::string& spec) {
+  std::stringstream ss(spec);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty())
+      continue;
+    auto eq = item.find('=');
+    if (eq == std::string::npos)
+      return false;
+    auto key = item.substr(0, eq);
+    auto str = item.substr(eq + 1);
+    if (key == "signal") {
+      signal = str;
+      continue;
+    }
+    char* end;
+    uint64_t value = strtoull(str.c_str(), &end, 0);
+    if (str.empty() || *end != '\0')
+      return false;
+    if (key == "start")        start = value;
+    else if (key == "stop")    stop = value;
+    else if (key == "length")  length = value;
+    else if (key == "history") history = value;
+    else if (key == "pc") {
+      pc = value;
+      has_pc = true;
+    }
+    else return false;
+  }
+  return true;
+}
+
+void TraceConfig::from_env() {
+  auto spec = getenv("VX_TRACE");
+  if (spec && !this->parse(spec)) {
+    std::cerr << "Warning: invalid VX_TRACE=" << spec << ", tracing the whole run" << std::endl;
+    *this = TraceConfig();
+  }
+}
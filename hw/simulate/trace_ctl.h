@@ -0,0 +1,193 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <functional>
+#include <iostream>
+
+// Waveform capture control for VCD_OUTPUT builds of rtlsim and vlsim.
+// Dumping every half cycle of a long kernel produces huge traces and slows
+// the run down many times, so capture can be limited to a region of
+// interest with a "key=value,..." spec, from VX_TRACE or vx_dev_trace():
+//   start=<cycle>   nothing is traced before this cycle
+//   stop=<cycle>    the trace is closed at this cycle
+//   pc=<addr>       wait for an instruction at addr to commit
+//   signal=<name>   wait for a top-level signal of the model to be set
+//   length=<n>      capture n cycles from the trigger
+//   history=<n>     while waiting for the trigger, dump into chunks of n
+//                   cycles and keep the previous chunk as <name>.pre.<ext>,
+//                   so at least n cycles before the trigger are kept
+// Without a spec the whole run is traced.
+struct TraceConfig {
+  TraceConfig()
+    : start(0)
+    , stop(0)
+    , pc(0)
+    , has_pc(false)
+    , length(0)
+    , history(0)
+  {}
+
+  uint64_t    start;
+  uint64_t    stop;
+  uint32_t    pc;
+  bool        has_pc;
+  std::string signal;
+  uint64_t    length;
+  uint64_t    history;
+
+  bool has_trigger() const {
+    return has_pc || !signal.empty();
+  }
+
+  // returns false on a malformed spec
+  bool parse(const std::string& spec);
+
+  // apply the VX_TRACE environment variable, if set
+  void from_env();
+};
+
+// PC trigger, fed by dpi_trace_pc() in VX_commit
+void trace_watch_pc(bool enable, uint32_t pc);
+
+// whether the watched PC committed since the last call
+bool trace_pc_hit();
+
+template <typename Trace>
+class TraceControl {
+public:
+
+  TraceControl()
+    : trace_(nullptr)
+    , state_(IDLE)
+    , is_open_(false)
+    , trigger_cycle_(0)
+    , chunk_start_(0)
+  {}
+
+  ~TraceControl() {
+    this->close();
+  }
+
+  void attach(Trace* trace, const std::string& filename) {
+    trace_ = trace;
+    filename_ = filename;
+    auto dot = filename.rfind('.');
+    pre_filename_ = (dot == std::string::npos) ? (filename + ".pre")
+                  : (filename.substr(0, dot) + ".pre" + filename.substr(dot));
+  }
+
+  // restart capture under a new config; probe evaluates the signal trigger.
+  // Without a probe for the signal, the signal trigger is dropped (it would
+  // keep the capture armed forever) and false is returned.
+  bool configure(const TraceConfig& config, const std::function<bool()>& probe) {
+    this->close();
+    config_ = config;
+    probe_ = probe;
+    state_ = IDLE;
+    bool valid = config.signal.empty() || probe;
+    if (!valid) {
+      std::cout << "warning: unknown trace signal " << config.signal << ", ignoring the signal trigger" << std::endl;
+      config_.signal.clear();
+    }
+    trace_watch_pc(config_.has_pc, config_.pc);
+    return valid;
+  }
+
+  const TraceConfig& config() const {
+    return config_;
+  }
+
+  // called on every eval in place of trace->dump()
+  void dump(uint64_t timestamp) {
+    if (state_ == DONE)
+      return;
+
+    uint64_t cycle = timestamp / 2;
+
+    if (state_ == IDLE) {
+      if (cycle < config_.start)
+        return;
+      if (config_.has_trigger()) {
+        state_ = ARMED;
+        trace_pc_hit(); // drop commits seen before the window
+        if (config_.history) {
+          this->open();
+          chunk_start_ = cycle;
+        }
+      } else {
+        state_ = CAPTURE;
+        trigger_cycle_ = cycle;
+        this->open();
+      }
+    }
+
+    if (config_.stop && cycle >= config_.stop) {
+      this->close();
+      state_ = DONE;
+      return;
+    }
+
+    if (state_ == ARMED) {
+      if (trace_pc_hit() || (probe_ && probe_())) {
+        std::cout << "[trace] triggered at cycle " << cycle << std::endl;
+        state_ = CAPTURE;
+        trigger_cycle_ = cycle;
+        this->open();
+      } else {
+        if (!config_.history)
+          return;
+        if (cycle - chunk_start_ >= config_.history) {
+          this->rotate();
+          chunk_start_ = cycle;
+        }
+      }
+    }
+
+    if (state_ == CAPTURE
+     && config_.length
+     && cycle >= trigger_cycle_ + config_.length) {
+      this->close();
+      state_ = DONE;
+      return;
+    }
+
+    trace_->dump(timestamp);
+  }
+
+  void close() {
+    if (is_open_) {
+      trace_->close();
+      is_open_ = false;
+    }
+  }
+
+private:
+
+  enum state_t { IDLE, ARMED, CAPTURE, DONE };
+
+  void open() {
+    if (!is_open_) {
+      trace_->open(filename_.c_str());
+      is_open_ = true;
+    }
+  }
+
+  // keep the current chunk as the pre-trigger history and start a new one
+  void rotate() {
+    this->close();
+    ::rename(filename_.c_str(), pre_filename_.c_str());
+    this->open();
+  }
+
+  Trace* trace_;
+  std::string filename_;
+  std::string pre_filename_;
+  TraceConfig config_;
+  std::function<bool()> probe_;
+  state_t state_;
+  bool is_open_;
+  uint64_t trigger_cycle_;
+  uint64_t chunk_start_;
+};
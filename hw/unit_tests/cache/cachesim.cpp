@@ -11,7 +11,15 @@ double sc_time_stamp() {
   return timestamp;
 }
 
-CacheSim::CacheSim() {
+static DramConfig dram_config() {
+  DramConfig config;
+  config.latency = DRAM_LATENCY;
+  config.block_size = GLOBAL_BLOCK_SIZE;
+  config.from_env();
+  return config;
+}
+
+CacheSim::CacheSim() : dram_queue_(dram_config()) {
   // force random values for uninitialized signals  
   Verilated::randReset(2);
 
@@ -39,7 +47,7 @@ CacheSim::~CacheSim() {
 
 void CacheSim::attach_ram(RAM* ram) {
   ram_ = ram;
-  dram_rsp_vec_.clear();
+  dram_queue_.clear();
 }
 
 void CacheSim::reset() {
@@ -52,7 +60,7 @@ void CacheSim::reset() {
   cache_->reset = 0;
   this->step();
 
-  dram_rsp_vec_.clear();
+  dram_queue_.clear();
   //clear req and rsp vecs
   
 }
@@ -162,17 +170,7 @@ void CacheSim::eval_dram_bus() {
     return;
   }
 
-  // schedule DRAM responses
-  int dequeue_index = -1;
-  for (int i = 0; i < dram_rsp_vec_.size(); i++) {
-    if (dram_rsp_vec_[i].cycles_left > 0) {
-      dram_rsp_vec_[i].cycles_left -= 1;
-    }
-    if ((dequeue_index == -1) 
-     && (dram_rsp_vec_[i].cycles_left == 0)) {
-      dequeue_index = i;
-    }
-  }
+  uint64_t cycle = timestamp / 2;
 
   // send DRAM response  
   if (dram_rsp_active_
@@ -181,15 +179,15 @@ void CacheSim::eval_dram_bus() {
     dram_rsp_active_ = false;
   }
   if (!dram_rsp_active_) {
-    if (dequeue_index != -1) { //time to respond to the request
+    auto dram_rsp = dram_queue_.front(cycle);
+    if (dram_rsp) { //time to respond to the request
       cache_->dram_rsp_valid = 1;
 
       //copy data from the rsp queue to the cache module
-      memcpy((uint8_t*)cache_->dram_rsp_data, dram_rsp_vec_[dequeue_index].data, GLOBAL_BLOCK_SIZE);
+      memcpy((uint8_t*)cache_->dram_rsp_data, dram_rsp->data.data(), GLOBAL_BLOCK_SIZE);
 
-      cache_->dram_rsp_tag = dram_rsp_vec_[dequeue_index].tag;    
-      free(dram_rsp_vec_[dequeue_index].data); //take data out of the queue
-      dram_rsp_vec_.erase(dram_rsp_vec_.begin() + dequeue_index);
+      cache_->dram_rsp_tag = dram_rsp->tag;    
+      dram_queue_.pop();
       dram_rsp_active_ = true;
     } else {
       cache_->dram_rsp_valid = 0;
@@ -197,35 +195,26 @@ void CacheSim::eval_dram_bus() {
   }
 
   // handle DRAM stalls
-  bool dram_stalled = false;
-#ifdef ENABLE_DRAM_STALLS
-  if (0 == ((timestamp/2) % DRAM_STALLS_MODULO)) { 
-    dram_stalled = true;
-  } else
-  if (dram_rsp_vec_.size() >= DRAM_RQ_SIZE) {
-    dram_stalled = true;
-  }
-#endif
+  bool dram_stalled = !dram_queue_.ready(cycle);
 
   // process DRAM requests
   if (!dram_stalled) {
     if (cache_->dram_req_valid) {
+      unsigned base_addr = (cache_->dram_req_addr * GLOBAL_BLOCK_SIZE);
       if (cache_->dram_req_rw) { //write = 1
         uint64_t byteen = cache_->dram_req_byteen;
-        unsigned base_addr = (cache_->dram_req_addr * GLOBAL_BLOCK_SIZE);
         uint8_t* data = (uint8_t*)(cache_->dram_req_data);
         for (int i = 0; i < GLOBAL_BLOCK_SIZE; i++) {
           if ((byteen >> i) & 0x1) {            
             (*ram_)[base_addr + i] = data[i];
           }
         }
+        dram_queue_.write(base_addr, cycle);
       } else {
         dram_req_t dram_req;
-        dram_req.cycles_left = DRAM_LATENCY;     
-        dram_req.data = (uint8_t*)malloc(GLOBAL_BLOCK_SIZE);
         dram_req.tag = cache_->dram_req_tag;
-        ram_->read(cache_->dram_req_addr * GLOBAL_BLOCK_SIZE, GLOBAL_BLOCK_SIZE, dram_req.data);
-        dram_rsp_vec_.push_back(dram_req);
+        ram_->read(base_addr, GLOBAL_BLOCK_SIZE, dram_req.data.data());
+        dram_queue_.read(base_addr, cycle, dram_req);
       } 
     }    
   }
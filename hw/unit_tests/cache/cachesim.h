@@ -10,19 +10,17 @@
 
 //#include <VX_config.h>
 #include "ram.h"
+#include "dram_sim.h"
 #include <ostream>
 #include <vector>
+#include <array>
 #include <queue>
 
-#define ENABLE_DRAM_STALLS
 #define DRAM_LATENCY 100
-#define DRAM_RQ_SIZE 16
-#define DRAM_STALLS_MODULO 16
 #define GLOBAL_BLOCK_SIZE 16
 
 typedef struct {
-  int cycles_left;
-  uint8_t *data;
+  std::array<uint8_t, GLOBAL_BLOCK_SIZE> data;
   unsigned tag;
 } dram_req_t;
 
@@ -74,7 +72,7 @@ private:
   void eval_dram_bus();
   
   std::queue<core_req_t*> core_req_vec_; 
-  std::vector<dram_req_t> dram_rsp_vec_;
+  DramQueue<dram_req_t> dram_queue_;
   std::map<unsigned int, unsigned int*> core_rsp_vec_;
   int dram_rsp_active_;
 
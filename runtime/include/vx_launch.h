@@ -0,0 +1,34 @@
+#ifndef VX_LAUNCH_H
+#define VX_LAUNCH_H
+
+// Launch list layout at LAUNCH_LIST_ADDR, shared by the host driver and
+// vx_start.S (preprocessor-only so it can be included from assembly).
+//
+//   +0x000  magic
+//   +0x004  number of kernels
+//   +0x010  per-core cursor (index of the kernel currently running)
+//   +0x110  kernel entries {pc, arg_dst, arg_src, arg_size}
+//   +0x510  argument blocks of the chained kernels
+//
+// When a kernel's main() returns, the runtime looks up the next entry,
+// copies its argument block to arg_dst and jumps to its pc.
+
+#define VX_LAUNCH_MAGIC         0x4c4c5856  // "VXLL"
+
+#define VX_LAUNCH_LIST_SIZE     0x2000
+#define VX_LAUNCH_MAX_CORES     64
+#define VX_LAUNCH_MAX_KERNELS   64
+
+#define VX_LAUNCH_MAGIC_OFF     0x000
+#define VX_LAUNCH_COUNT_OFF     0x004
+#define VX_LAUNCH_CURSOR_OFF    0x010
+#define VX_LAUNCH_ENTRY_OFF     0x110
+#define VX_LAUNCH_ARGS_OFF      0x510
+
+#define VX_LAUNCH_ENTRY_SIZE    16
+#define VX_LAUNCH_PC            0
+#define VX_LAUNCH_ARG_DST       4
+#define VX_LAUNCH_ARG_SRC       8
+#define VX_LAUNCH_ARG_SIZE      12
+
+#endif
@@ -10,6 +10,8 @@ extern "C" {
 
 typedef void (*func_t)(void *);
 
+// runs func_ptr on min(num_warps, hardware warps) warps and returns once all
+// of them are done; barrier NUM_BARRIERS-1 is reserved for joining them
 void vx_spawn_warps(int num_warps, int num_threads, func_t func_ptr , void * args);
 
 #ifdef __cplusplus
@@ -1,6 +1,10 @@
 #include <vx_spawn.h>
 #include <vx_intrinsics.h>
 #include <inttypes.h>
+#include <VX_config.h>
+
+// joins the spawned warps, kept out of the kernels' barrier ids
+#define SPAWN_BARRIER_ID (NUM_BARRIERS - 1)
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +14,7 @@ typedef struct {
 	func_t function;
 	void * arguments;
 	int    nthreads;
+	int    nwarps;
 } spawn_t;
 
 spawn_t* g_spawn = NULL;
@@ -21,6 +26,11 @@ void spawn_warp_runonce() {
 	// call user routine
 	g_spawn->function(g_spawn->arguments);
 
+	// wait for all warps so the caller returns only once the work is done
+	if (g_spawn->nwarps > 1) {
+		vx_barrier(SPAWN_BARRIER_ID, g_spawn->nwarps);
+	}
+
 	// resume single-thread execution on exit
 	int wid = vx_warp_id();
 	unsigned tmask = (0 == wid) ? 0x1 : 0x0; 
@@ -28,7 +38,13 @@ void spawn_warp_runonce() {
 }
 
 void vx_spawn_warps(int num_warps, int num_threads, func_t func_ptr , void * args) {
-	spawn_t spawn = { func_ptr, args, num_threads };
+	// wspawn starts at most the hardware warp count
+	int nw = vx_num_warps();
+	if (num_warps > nw) {
+		num_warps = nw;
+	}
+
+	spawn_t spawn = { func_ptr, args, num_threads, num_warps };
 	g_spawn = &spawn;
 
 	if (num_warps > 1) {
@@ -36,7 +36,15 @@ void CommandLineArg::readArgs(int argc, char **argv) {
     } else if (l != longArgs.end()) {
       i += l->second->read(argc - i, &argv[i]);
     } else {
-      throw BadArg(string(argv[i]));
+      // --name=value reads as --name value
+      string arg(argv[i]);
+      size_t eq = arg.find('=');
+      if (eq == string::npos) throw BadArg(arg);
+      string name(arg, 0, eq), value(arg, eq + 1);
+      l = longArgs.find(name);
+      char *split[] = { &name[0], &value[0] };
+      if (l == longArgs.end() || l->second->read(2, split) != 1)
+        throw BadArg(arg);
     }
   }
 }
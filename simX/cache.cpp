@@ -0,0 +1,242 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#include <iostream>
+#include <algorithm>
+
+#include "include/debug.h"
+#include "include/types.h"
+#include "include/cache.h"
+#include "include/checkpoint.h"
+
+// VX_config.h uses MAX() for some of the queue sizes
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#include <VX_config.h>
+
+// Cycles for a line request to DRAM, matching hw/simulate
+#ifndef DRAM_LATENCY
+#define DRAM_LATENCY 4
+#endif
+
+// Cycles to service a hit in a lower-level cache
+#ifndef CACHE_HIT_LATENCY
+#define CACHE_HIT_LATENCY 2
+#endif
+
+// Ways per set; VX_cache is direct-mapped
+#ifndef ICACHE_WAYS
+#define ICACHE_WAYS 1
+#endif
+#ifndef DCACHE_WAYS
+#define DCACHE_WAYS 1
+#endif
+#ifndef L2CACHE_WAYS
+#define L2CACHE_WAYS 1
+#endif
+#ifndef L3CACHE_WAYS
+#define L3CACHE_WAYS 1
+#endif
+
+using namespace std;
+using namespace Harp;
+
+CacheConfig Harp::icacheConfig() {
+  CacheConfig c = {"icache", ICACHE_SIZE, IBANK_LINE_SIZE, INUM_BANKS,
+                   IWORD_SIZE, ICACHE_WAYS, IMRVQ_SIZE, 1, true};
+  return c;
+}
+
+CacheConfig Harp::dcacheConfig() {
+  CacheConfig c = {"dcache", DCACHE_SIZE, DBANK_LINE_SIZE, DNUM_BANKS,
+                   DWORD_SIZE, DCACHE_WAYS, DMRVQ_SIZE, 1, true};
+  return c;
+}
+
+CacheConfig Harp::smemConfig() {
+  CacheConfig c = {"smem", SCACHE_SIZE, SBANK_LINE_SIZE, SNUM_BANKS,
+                   SWORD_SIZE, 1, 1, 1, false};
+  return c;
+}
+
+CacheConfig Harp::l2cacheConfig() {
+  CacheConfig c = {"l2cache", L2CACHE_SIZE, L2BANK_LINE_SIZE, L2NUM_BANKS,
+                   L2WORD_SIZE, L2CACHE_WAYS, L2MRVQ_SIZE, CACHE_HIT_LATENCY,
+                   true};
+  return c;
+}
+
+CacheConfig Harp::l3cacheConfig() {
+  CacheConfig c = {"l3cache", L3CACHE_SIZE, L3BANK_LINE_SIZE, L3NUM_BANKS,
+                   L3WORD_SIZE, L3CACHE_WAYS, L3MRVQ_SIZE, CACHE_HIT_LATENCY,
+                   true};
+  return c;
+}
+
+static Size ceilLog2(Size x) {
+  Size r = 0;
+  while ((1u << r) < x) ++r;
+  return r;
+}
+
+Cache::Cache(const CacheConfig &config, Cache *next, bool shared) :
+  config(config), next(next), shared(shared), tick(0)
+{
+  if (this->config.ways == 0) this->config.ways = 1;
+  if (this->config.mshr_size == 0) this->config.mshr_size = 1;
+
+  bank_bits = ceilLog2(config.num_banks);
+  line_bits = ceilLog2(config.line_size);
+  sets = config.size / (config.line_size * config.num_banks * this->config.ways);
+  if (sets == 0) sets = 1;
+
+  tags.resize(config.num_banks * sets * this->config.ways, 0);
+  lru.resize(tags.size(), 0);
+  bank_load.resize(config.num_banks, 0);
+
+  D(1, "Cache " << config.name << ": " << config.size << " bytes, "
+       << config.num_banks << " banks, " << sets << " sets, "
+       << this->config.ways << " ways, " << config.line_size << "-byte lines");
+}
+
+bool Cache::lookup(Addr line, bool allocate) {
+  if (!config.dram_enable) return true;
+
+  Size bank = line & (config.num_banks - 1);
+  Size set  = (line >> bank_bits) % sets;
+  Size base = (bank * sets + set) * config.ways;
+  Addr tag  = line + 1;
+
+  Size victim = base;
+  for (Size i = base; i < base + config.ways; ++i) {
+    if (tags[i] == tag) {
+      lru[i] = ++tick;
+      return true;
+    }
+    if (lru[i] < lru[victim]) victim = i;
+  }
+
+  if (allocate) {
+    if (tags[victim] != 0) ++stats.evictions;
+    tags[victim] = tag;
+    lru[victim] = ++tick;
+  }
+
+  return false;
+}
+
+Size Cache::nextLatency(Addr line, bool write) {
+  if (next) return next->fill(line << line_bits, write);
+  return config.dram_enable ? DRAM_LATENCY : 0;
+}
+
+Size Cache::access(const Addr *addr, const bool *valid, Size n, bool write) {
+  std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+  if (shared) lock.lock();
+
+  // Distinct lines requested by the warp and their bank load
+  Addr lines[32];
+  Size nlines = 0;
+  Size max_load = 0;
+  std::fill(bank_load.begin(), bank_load.end(), 0);
+
+  for (Size t = 0; t < n && t < 32; ++t) {
+    if (!valid[t]) continue;
+    Addr line = addr[t] >> line_bits;
+    bool dup = false;
+    for (Size i = 0; i < nlines; ++i) {
+      if (lines[i] == line) { dup = true; break; }
+    }
+    if (dup) continue;
+    lines[nlines++] = line;
+    Size bank = line & (config.num_banks - 1);
+    max_load = std::max(max_load, ++bank_load[bank]);
+  }
+
+  if (nlines == 0) return 0;
+
+  Size stall = max_load - 1;
+  stats.bank_conflicts += stall;
+
+  if (write) {
+    // Write-through, no write-allocate
+    stats.writes += nlines;
+    for (Size i = 0; i < nlines; ++i) {
+      lookup(lines[i], false);
+      if (next) next->fill(lines[i] << line_bits, true);
+    }
+    return stall;
+  }
+
+  stats.reads += nlines;
+
+  // Misses are sent down mshr_size at a time; each batch costs its slowest fill
+  Size pending = 0, batch = 0;
+  for (Size i = 0; i < nlines; ++i) {
+    if (lookup(lines[i], true)) {
+      ++stats.hits;
+      continue;
+    }
+    ++stats.misses;
+    batch = std::max(batch, nextLatency(lines[i], false));
+    if (++pending == config.mshr_size) {
+      stall += batch;
+      pending = 0;
+      batch = 0;
+    }
+  }
+  stall += batch;
+
+  return stall;
+}
+
+Size Cache::fill(Addr addr, bool write) {
+  std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+  if (shared) lock.lock();
+
+  Addr line = addr >> line_bits;
+
+  if (write) {
+    ++stats.writes;
+    lookup(line, false);
+    if (next) next->fill(addr, true);
+    return config.hit_latency;
+  }
+
+  ++stats.reads;
+  if (lookup(line, true)) {
+    ++stats.hits;
+    return config.hit_latency;
+  }
+
+  ++stats.misses;
+  return config.hit_latency + nextLatency(line, false);
+}
+
+void Cache::printStats(ostream &os) const {
+  os << dec << config.name << ": reads=" << stats.reads
+       << " writes=" << stats.writes
+       << " hits=" << stats.hits
+       << " misses=" << stats.misses
+       << " bank_conflicts=" << stats.bank_conflicts
+       << " evictions=" << stats.evictions << endl;
+}
+
+void Cache::save(CheckpointWriter &w) const {
+  w.putVector(tags);
+  w.putVector(lru);
+  w.put(tick);
+  w.putVector(bank_load);
+  w.put(stats);
+}
+
+void Cache::restore(CheckpointReader &r) {
+  // Sizes must match this cache's geometry
+  r.getVector(tags);
+  r.getVector(lru);
+  r.get(tick);
+  r.getVector(bank_load);
+  r.get(stats);
+}
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <ram.h>
+
+#include "include/checkpoint.h"
+#include "include/core.h"
+
+using namespace Harp;
+using namespace std;
+
+namespace {
+  struct CheckpointHeader {
+    uint32_t magic, version;
+    uint32_t warps, threads, regs, pageSize;
+  };
+
+  const Size PAGE_SIZE = 4096;
+
+  /* Pages of ram that are present or swapped out, from /proc/self/pagemap
+     (bits 63 and 62); falls back to mincore(), which misses swapped pages.
+     Pages the guest never touched are not committed and read as zero. */
+  vector<uint32_t> committedPages(const ::RAM &ram) {
+    vector<uint32_t> pages;
+    uint64_t nPages = ram.size() / PAGE_SIZE;
+    uintptr_t first = uintptr_t(ram.base()) / PAGE_SIZE;
+
+    int fd = open("/proc/self/pagemap", O_RDONLY);
+    if (fd >= 0) {
+      static const uint64_t CHUNK = 1 << 16;
+      vector<uint64_t> entries(CHUNK);
+      for (uint64_t p = 0; p < nPages; p += CHUNK) {
+        ssize_t bytes = pread(fd, entries.data(), CHUNK * sizeof(uint64_t),
+                              (first + p) * sizeof(uint64_t));
+        if (bytes < ssize_t(CHUNK * sizeof(uint64_t))) {
+          pages.clear();
+          break;
+        }
+        for (uint64_t i = 0; i < CHUNK; ++i)
+          if (entries[i] >> 62) pages.push_back((p + i) * PAGE_SIZE);
+      }
+      close(fd);
+      if (!pages.empty()) return pages;
+    }
+
+    vector<unsigned char> resident(nPages);
+    if (mincore(ram.base(), ram.size(), resident.data()) == 0) {
+      for (uint64_t p = 0; p < nPages; ++p)
+        if (resident[p] & 1) pages.push_back(p * PAGE_SIZE);
+    }
+    return pages;
+  }
+
+  bool isZero(const uint8_t *p, Size n) {
+    static const uint8_t zero[PAGE_SIZE] = {};
+    return memcmp(p, zero, n) == 0;
+  }
+}
+
+bool Harp::saveCheckpoint(const string &path, const Core &core,
+                          const ::RAM &ram)
+{
+  FILE *f = fopen(path.c_str(), "wb");
+  if (!f) {
+    cerr << "Warning: cannot write checkpoint " << path << "\n";
+    return false;
+  }
+  setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+  CheckpointWriter w(f);
+  CheckpointHeader h = {
+    CHECKPOINT_MAGIC, CHECKPOINT_VERSION, Word(core.w.size()),
+    Word(core.a.getNThds()), Word(core.a.getNRegs()), Word(PAGE_SIZE)
+  };
+  w.put(h);
+  core.save(w);
+
+  // Only pages holding data; everything else restores as zero
+  vector<uint32_t> pages;
+  for (uint32_t addr : committedPages(ram))
+    if (!isZero(ram.get(addr), PAGE_SIZE)) pages.push_back(addr);
+  w.put<uint64_t>(pages.size());
+  for (uint32_t addr : pages) {
+    w.put(addr);
+    w.putBytes(ram.get(addr), PAGE_SIZE);
+  }
+
+  bool ok = w.ok && (fclose(f) == 0);
+  if (!ok) cerr << "Warning: error writing checkpoint " << path << "\n";
+  return ok;
+}
+
+bool Harp::restoreCheckpoint(const string &path, Core &core, ::RAM &ram)
+{
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f) {
+    cerr << "Cannot open checkpoint " << path << "\n";
+    return false;
+  }
+  setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+  CheckpointReader r(f);
+  CheckpointHeader h;
+  r.get(h);
+  if (!r.ok || h.magic != CHECKPOINT_MAGIC) {
+    cerr << path << " is not a simX checkpoint\n";
+    fclose(f);
+    return false;
+  }
+  if (h.version != CHECKPOINT_VERSION || h.pageSize != PAGE_SIZE) {
+    cerr << path << ": unsupported checkpoint version " << h.version << "\n";
+    fclose(f);
+    return false;
+  }
+  if (h.warps != core.w.size() || h.threads != core.a.getNThds()
+      || h.regs != core.a.getNRegs()) {
+    cerr << path << ": checkpoint of a " << h.warps << "-warp, " << h.threads
+         << "-thread core\n";
+    fclose(f);
+    return false;
+  }
+
+  core.restore(r);
+
+  ram.clear();
+  uint64_t nPages = 0;
+  r.get(nPages);
+  for (uint64_t i = 0; r.ok && i < nPages; ++i) {
+    uint32_t addr = 0;
+    r.get(addr);
+    if (addr % PAGE_SIZE) r.ok = false;
+    else r.getBytes(ram.get(addr), PAGE_SIZE);
+  }
+
+  fclose(f);
+  if (!r.ok) cerr << path << ": truncated or mismatched checkpoint\n";
+  return r.ok;
+}
@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include  <iomanip>
+#include <string.h>
 
 // #define USE_DEBUG 7
 // #define PRINT_ACTIVE_THREADS
@@ -16,41 +17,30 @@
 #include "include/core.h"
 #include "include/debug.h"
 
+#include <VX_config.h>
+
 #ifdef EMU_INSTRUMENTATION
 #include "include/qsim-harp.h"
 #endif
 
 
-#define NO_MEM_READ  7
-#define LB_MEM_READ  0
-#define LH_MEM_READ  1
-#define LW_MEM_READ  2
-#define LBU_MEM_READ 4
-#define LHU_MEM_READ 5
-
-
-#define NO_MEM_WRITE 7
-#define SB_MEM_WRITE 0
-#define SH_MEM_WRITE 1
-#define SW_MEM_WRITE 2
-
 #define INIT_TRACE(trace_inst) \
       trace_inst.valid_inst         = false; \
       trace_inst.pc                 = 0; \
       trace_inst.wid                = schedule_w; \
       trace_inst.rs1                = -1; \
       trace_inst.rs2                = -1; \
+      trace_inst.rs3                = -1; \
       trace_inst.rd                 = -1; \
       trace_inst.vs1                = -1; \
       trace_inst.vs2                = -1; \
       trace_inst.vd                 = -1; \
       trace_inst.is_lw              = false; \
       trace_inst.is_sw              = false; \
-      if (trace_inst.mem_addresses != NULL) free(trace_inst.mem_addresses); \
-      trace_inst.mem_addresses      = (unsigned *) malloc(32 * sizeof(unsigned)); \
-      for (int tid = 0; tid < a.getNThds(); tid++) trace_inst.mem_addresses[tid] = 0xdeadbeef; \
+      for (unsigned tid = 0; tid < a.getNThds(); tid++) trace_inst.mem_addresses[tid] = 0xdeadbeef; \
       trace_inst.mem_stall_cycles   = 0; \
       trace_inst.fetch_stall_cycles = 0; \
+      trace_inst.exe_stall_cycles   = 0; \
       trace_inst.stall_warp         = false; \
       trace_inst.wspawn             = false; \
       trace_inst.stalled            = false;
@@ -61,15 +51,17 @@
       drain.wid                = source.wid; \
       drain.rs1                = source.rs1; \
       drain.rs2                = source.rs2; \
+      drain.rs3                = source.rs3; \
       drain.rd                 = source.rd; \
       drain.vs1                = source.vs1; \
       drain.vs2                = source.vs2; \
       drain.vd                 = source.vd; \
       drain.is_lw              = source.is_lw; \
       drain.is_sw              = source.is_sw; \
-      for (int tid = 0; tid < a.getNThds(); tid++) drain.mem_addresses[tid] = source.mem_addresses[tid]; \
+      for (unsigned tid = 0; tid < a.getNThds(); tid++) drain.mem_addresses[tid] = source.mem_addresses[tid]; \
       drain.mem_stall_cycles   = source.mem_stall_cycles; \
       drain.fetch_stall_cycles = source.fetch_stall_cycles; \
+      drain.exe_stall_cycles   = source.exe_stall_cycles; \
       drain.stall_warp         = source.stall_warp; \
       drain.wspawn             = source.wspawn; \
       drain.stalled            = false;
@@ -78,6 +70,7 @@ using namespace Harp;
 using namespace std;
 
 
+#ifdef USE_DEBUG
 void printTrace(trace_inst_t * trace, const char * stage_name)
 {
     D(3, stage_name << ": valid=" << trace->valid_inst);
@@ -92,6 +85,9 @@ void printTrace(trace_inst_t * trace, const char * stage_name)
     D(3, stage_name << ": wspawn=" << trace->wspawn);
     D(3, stage_name << ": stalled=" << trace->stalled);
 }
+#else
+void printTrace(trace_inst_t *, const char *) {}
+#endif
 
 #ifdef EMU_INSTRUMENTATION
 void Harp::reg_doRead(Word cpuId, Word regNum) {
@@ -103,12 +99,28 @@ void Harp::reg_doWrite(Word cpuId, Word regNum) {
 }
 #endif
 
-Core::Core(const ArchDef &a, Decoder &d, MemoryUnit &mem, Word id):
-  a(a), iDec(d), mem(mem), steps(4), num_cycles(0), num_instructions(0)
+Core::Core(const ArchDef &a, Decoder &d, MemoryUnit &mem, Word id,
+           Word num_cores, GlobalBarrier *global_barrier, Cache *next_level):
+  icache(icacheConfig(), next_level), dcache(dcacheConfig(), next_level),
+  smem(smemConfig()), functional(false), a(a), iDec(d), mem(mem),
+  decodeCache(d, mem), id(id), num_cores(num_cores),
+  global_barrier(global_barrier), steps(4), num_cycles(0), num_instructions(0),
+  barrier_cycles(0), barriers(NUM_BARRIERS, 0), globalSeen(0)
 {
+  if (a.getNWarps() > MAX_WARPS) {
+    cerr << "Error: " << a.getNWarps() << " warps per core, at most "
+         << MAX_WARPS << " supported.\n";
+    abort();
+  }
+
   release_warp = false;
+  activeWarps = stalledWarps = barrierWarps = globalWarps = 0;
+  schedStalled = fetchStalled = 0;
   foundSchedule = true;
   schedule_w = 0;
+  issuedWarp = -1;
+  frontStall = schedStall = STALL_NUM_REASONS;
+  frontStallPc = 0;
 
   memset(&inst_in_fetch, 0, sizeof(inst_in_fetch));
   memset(&inst_in_decode, 0, sizeof(inst_in_decode));
@@ -124,9 +136,10 @@ Core::Core(const ArchDef &a, Decoder &d, MemoryUnit &mem, Word id):
   INIT_TRACE(inst_in_lsu);
   INIT_TRACE(inst_in_wb);
 
+  memset(&inst_functional, 0, sizeof(inst_functional));
+
   for (int i = 0; i < 32; i++) {
-    stallWarp[i] = false;
-    for (int j = 0; j < 32; j++) {
+    for (int j = 0; j < 64; j++) {
         renameTable[i][j] = true;
     }
   }
@@ -135,29 +148,29 @@ Core::Core(const ArchDef &a, Decoder &d, MemoryUnit &mem, Word id):
     vecRenameTable[i] = true;
   }
 
-  cache_simulator = new Vcache_simX;
-
-  // m_trace = new VerilatedVcdC;
-  // cache_simulator->trace(m_trace, 99);
-  // m_trace->open("simXtrace.vcd");
-
-  cache_simulator->reset = 1;
-  cache_simulator->clk   = 0;
-  cache_simulator->eval();
-  // m_trace->dump(10);
-  cache_simulator->reset = 1;
-  cache_simulator->clk   = 1;
-  cache_simulator->eval();
-  // m_trace->dump(11);
-  cache_simulator->reset = 0;
-  cache_simulator->clk   = 0;
-
   for (unsigned i = 0; i < a.getNWarps(); ++i) {
     w.push_back(Warp(this, i));
   }
 
   w[0].activeThreads = 1;
   w[0].spawned = true;
+  updateActive(0);
+
+  sched.reset(new LrrScheduler(w.size()));
+}
+
+bool Core::setScheduler(const std::string &policy)
+{
+    WarpScheduler *s = makeScheduler(policy, w.size());
+    if (!s) return false;
+    sched.reset(s);
+    return true;
+}
+
+void Core::updateActive(Word wid)
+{
+    if (w[wid].activeThreads) activeWarps |= WarpMask(1) << wid;
+    else activeWarps &= ~(WarpMask(1) << wid);
 }
 
 bool Core::interrupt(Word r0) {
@@ -167,17 +180,20 @@ bool Core::interrupt(Word r0) {
 
 void Core::step()
 {
+    if (global_barrier) this->waitGlobalBarrier();
+
+    if (functional) {
+      this->functionalStep();
+      return;
+    }
+
     D(3, "###########################################################");
 
     steps++;
     this->num_cycles++;
+    this->barrier_cycles += threadCount(barrierWarps);
     D(3, "cycle: " << this->num_cycles);
-
-    DPH(3, "stalled warps:");
-    for (int widd = 0; widd < a.getNWarps(); widd++) {
-        DPN(3, " " << stallWarp[widd]);
-    }
-    DPN(3, "\n");
+    D(3, "stalled warps: 0x" << hex << stalledWarps << ", barrier warps: 0x" << barrierWarps << dec);
   
     // cout << "Rename table\n";
     // for (int regii = 0; regii < 32; regii++)
@@ -204,190 +220,203 @@ void Core::step()
     if (release_warp)
     {
         release_warp = false;
-        stallWarp[release_warp_num] = false;
+        stalledWarps &= ~(WarpMask(1) << release_warp_num);
     }
 
+    if (trace && trace->stages) this->traceStages();
+    if (perf) this->countCycle();
+
     DPN(3, flush);
 }
 
-void Core::getCacheDelays(trace_inst_t * trace_inst)
+void Core::enableProfile()
 {
-    static int curr_cycle = 0;
-    if (trace_inst->valid_inst)
-    {
-
-        std::vector<bool> in_dcache_in_valid(a.getNThds());
-        std::vector<unsigned> in_dcache_in_address(a.getNThds());
-
-        unsigned in_dcache_mem_read;
-        unsigned in_dcache_mem_write;
-        if (trace_inst->is_lw)
-        {
-            in_dcache_mem_read  = LW_MEM_READ;
-            in_dcache_mem_write = NO_MEM_WRITE;
-        }
-        else if (trace_inst->is_sw)
-        {
-            in_dcache_mem_read  = NO_MEM_READ;
-            in_dcache_mem_write = SW_MEM_WRITE;
-        }
-        else
-        {
-            in_dcache_mem_read  = NO_MEM_READ;
-            in_dcache_mem_write = NO_MEM_WRITE;
-        }
-
-        for (int j = 0; j < a.getNThds(); j++)
-        {
-            if ((w[trace_inst->wid].tmask[j]) && (trace_inst->is_sw || trace_inst->is_lw))
-            {
-                in_dcache_in_valid[j]   = true;
-                in_dcache_in_address[j] = trace_inst->mem_addresses[j];
-            }
-            else
-            {
-                in_dcache_in_valid[j]   = false;
-                in_dcache_in_address[j] = 0xdeadbeef;
-            }
-        }
-
-        cache_simulator->clk = 1;
-        cache_simulator->eval();
-        // m_trace->dump(2*curr_cycle);
+    perf.reset(new PerfCounters(id, w.size()));
+}
 
-        cache_simulator->icache_pc_addr       = trace_inst->pc;
-        cache_simulator->icache_valid_pc_addr = 1;
+void Core::countCycle()
+{
+    ++perf->cycles;
+    if (frontStall != STALL_NUM_REASONS) ++perf->pcs[frontStallPc].stalls;
 
-        // DCache start
-        cache_simulator->dcache_mem_read  = in_dcache_mem_read;
-        cache_simulator->dcache_mem_write = in_dcache_mem_write;
-        for (int cur_t = 0; cur_t < a.getNThds(); cur_t++)
-        {
-            cache_simulator->dcache_in_valid[cur_t]   = in_dcache_in_valid[cur_t];
-            cache_simulator->dcache_in_addr[cur_t] = in_dcache_in_address[cur_t];
+    for (unsigned i = 0; i < w.size(); ++i)
+    {
+        WarpMask bit = WarpMask(1) << i;
+        if ((int)i == issuedWarp) {
+            ++perf->warps[i].issued;
+        } else if (!(activeWarps & bit)) {
+            ++perf->warps[i].idle;
+        } else if (barrierWarps & bit) {
+            perf->stall(i, STALL_BARRIER);
+        } else if (frontStall != STALL_NUM_REASONS) {
+            perf->stall(i, frontStall);
+        } else {
+            perf->stall(i, (fetchStalled & bit) ? STALL_CONTROL : STALL_ISSUE);
         }
-        // DCache end
-        cache_simulator->clk = 0;
-        cache_simulator->eval();
-        // m_trace->dump(2*curr_cycle+1);
-
-        curr_cycle++;
-
-        while((cache_simulator->icache_stall || cache_simulator->dcache_stall))
-        {
-
-            ////////// Feed input
-            if (cache_simulator->icache_stall)
-            {
-                cache_simulator->icache_pc_addr       = trace_inst->pc;
-                cache_simulator->icache_valid_pc_addr = 1;
-                trace_inst->fetch_stall_cycles++;
-            }
-            else
-            {
-                cache_simulator->icache_valid_pc_addr = 0;
-            }
-
-            if (cache_simulator->dcache_stall)
-            {
-                cache_simulator->dcache_mem_read  = in_dcache_mem_read;
-                cache_simulator->dcache_mem_write = in_dcache_mem_write;
-                for (int cur_t = 0; cur_t < a.getNThds(); cur_t++)
-                {
-                    cache_simulator->dcache_in_valid[cur_t]   = in_dcache_in_valid[cur_t];
-                    cache_simulator->dcache_in_addr[cur_t] = in_dcache_in_address[cur_t];
-                }
-                trace_inst->mem_stall_cycles++;
-            }
-            else
-            {
-                cache_simulator->dcache_mem_read  = NO_MEM_READ;
-                cache_simulator->dcache_mem_write = NO_MEM_WRITE;
-                for (int cur_t = 0; cur_t < a.getNThds(); cur_t++)
-                {
-                    cache_simulator->dcache_in_valid[cur_t]   = 0;
-                }
-            }
+    }
+}
 
-            cache_simulator->clk = 1;
-            cache_simulator->eval();
-            // m_trace->dump(2*curr_cycle);
+void Core::setTrace(TraceSink *sink)
+{
+    trace.reset((sink && sink->good()) ? new TraceWriter(*sink) : nullptr);
+}
 
-            //////// Feed input
-            if (cache_simulator->icache_stall)
-            {
-                cache_simulator->icache_pc_addr       = trace_inst->pc;
-                cache_simulator->icache_valid_pc_addr = 1;
-            }
-            else
-            {
-                cache_simulator->icache_valid_pc_addr = 0;
-            }
+void Core::traceStages()
+{
+    const trace_inst_t *stages[TRACE_NUM_STAGES] = {
+      &inst_in_fetch, &inst_in_decode, &inst_in_scheduler,
+      &inst_in_exe, &inst_in_lsu, &inst_in_wb
+    };
 
-            if (cache_simulator->dcache_stall)
-            {
-                cache_simulator->dcache_mem_read  = in_dcache_mem_read;
-                cache_simulator->dcache_mem_write = in_dcache_mem_write;
-                for (int cur_t = 0; cur_t < a.getNThds(); cur_t++)
-                {
-                    cache_simulator->dcache_in_valid[cur_t]   = in_dcache_in_valid[cur_t];
-                    cache_simulator->dcache_in_addr[cur_t] = in_dcache_in_address[cur_t];
-                }
-            }
-            else
-            {
-                cache_simulator->dcache_mem_read  = NO_MEM_READ;
-                cache_simulator->dcache_mem_write = NO_MEM_WRITE;
-                for (int cur_t = 0; cur_t < a.getNThds(); cur_t++)
-                {
-                    cache_simulator->dcache_in_valid[cur_t]   = 0;
-                }
-            }
+    for (int i = 0; i < TRACE_NUM_STAGES; ++i)
+    {
+        const trace_inst_t *t = stages[i];
+        if (!t->valid_inst) continue;
+
+        TraceRecord r;
+        r.cycle       = num_cycles;
+        r.pc          = t->pc;
+        r.tmask       = 0;
+        r.core        = id;
+        r.type        = TRACE_STAGE;
+        r.stage       = i;
+        r.wid         = t->wid;
+        r.rd          = t->rd;
+        r.rs1         = t->rs1;
+        r.rs2         = t->rs2;
+        r.fetch_stall = t->fetch_stall_cycles;
+        r.mem_stall   = t->mem_stall_cycles;
+        r.flags       = (t->is_lw ? TRACE_F_LOAD : 0)
+                      | (t->is_sw ? TRACE_F_STORE : 0)
+                      | (t->stall_warp ? TRACE_F_STALL_WARP : 0)
+                      | (t->wspawn ? TRACE_F_WSPAWN : 0)
+                      | (t->stalled ? TRACE_F_STALLED : 0);
+        trace->push(r);
+    }
+}
 
-            cache_simulator->clk = 0;
-            cache_simulator->eval();
-            // m_trace->dump(2*curr_cycle+1);
+void Core::functionalStep()
+{
+    steps++;
+    this->num_cycles++;
+    this->barrier_cycles += threadCount(barrierWarps);
+
+    if (perf) {
+      ++perf->cycles;
+      for (unsigned i = 0; i < w.size(); ++i) {
+        WarpMask bit = WarpMask(1) << i;
+        if (!(activeWarps & bit)) ++perf->warps[i].idle;
+        else if (barrierWarps & bit) perf->stall(i, STALL_BARRIER);
+      }
+    }
 
-            
-            curr_cycle++;
-            
-        }
+    // Warps in id order; ones spawned or released by a lower warp's step
+    // still run this cycle
+    WarpMask m = activeWarps & ~barrierWarps;
+    while (m) {
+      unsigned i = __builtin_ctz(m);
+      Warp &warp = w[i];
+
+      if (perf) ++perf->warps[i].issued;
+      this->num_instructions = this->num_instructions + warp.activeThreads;
+      inst_functional.wid = i;
+      inst_functional.is_lw = inst_functional.is_sw = false;
+      inst_functional.stall_warp = inst_functional.wspawn = false;
+      warp.step(&inst_functional);
+
+      m = activeWarps & ~barrierWarps & ~threadMaskLow(i + 1);
+    }
+}
 
+void Core::waitGlobalBarrier()
+{
+    // Park the host thread while every running warp waits on a global barrier
+    for (;;) {
+      uint64_t seen = global_barrier->releases;
+      this->pollGlobalBarrier();
+      if (!activeWarps || (activeWarps & ~globalWarps)) return;
+      global_barrier->wait(seen);
     }
 }
 
-void Core::warpScheduler()
+void Core::pollGlobalBarrier()
 {
-    int numSteps = 0;
-    bool cont;
+    // Only a release since the last poll can free a parked warp
+    if (!globalWarps || global_barrier->releases == globalSeen) return;
+    globalSeen = global_barrier->releases;
+    for (WarpMask m = globalWarps; m; m &= m - 1) {
+      unsigned i = __builtin_ctz(m);
+      if (!w[i].barrierWaiting()) {
+        globalWarps &= ~(WarpMask(1) << i);
+        barrierWarps &= ~(WarpMask(1) << i);
+      }
+    }
+}
 
-    do
-    {
-        numSteps++;
-        schedule_w = (schedule_w+1) % w.size();
+void Core::barrier(Word wid, Word id, Word count)
+{
+    WarpMask bit = WarpMask(1) << wid;
+
+    if ((id & 0x80000000) && global_barrier) {
+      Warp &warp = w[wid];
+      warp.barrierId = id;
+      warp.barrierGen = global_barrier->arrive(id, count, &warp.barrierSeen);
+      warp.barrierWait = true;
+      barrierWarps |= bit;
+      globalWarps |= bit;
+      return;
+    }
 
-        bool has_active_threads = (w[schedule_w].activeThreads > 0);
-        bool stalled        = stallWarp[schedule_w];
+    // Without a device-wide barrier a global id is local to the one core
+    WarpMask &parked = barriers[(id & 0x7fffffff) % barriers.size()];
+    parked |= bit;
+    if (threadCount(parked) < count) {
+      barrierWarps |= bit;
+      return;
+    }
 
-        cont = ((!has_active_threads) || (stalled)) && (numSteps <= w.size());
+    D(3, "Barrier " << id << " released warps 0x" << hex << parked << dec);
+    barrierWarps &= ~parked;
+    parked = 0;
+}
 
-        // cout << "&&&&&&&WID: " << schedule_w << '\n';
-        // cout << "activeThreads: " << w[schedule_w].activeThreads << "\t!has_active_threads: " << (!has_active_threads) << '\n'; 
+void Core::getCacheDelays(trace_inst_t * trace_inst)
+{
+    if (!trace_inst->valid_inst)
+        return;
 
-        // cout << "stalled: "  << stalled << '\n';
-        // cout << "numSteps: " << numSteps << " CONT: " << cont << '\n';
+    Addr pc = trace_inst->pc;
+    bool pc_valid = true;
+    trace_inst->fetch_stall_cycles += icache.access(&pc, &pc_valid, 1, false);
 
-    } while (cont);
+    if (!trace_inst->is_lw && !trace_inst->is_sw)
+        return;
 
-    if (numSteps > w.size())
+    Addr addr[32];
+    bool valid[32];
+    int first = -1;
+    for (unsigned j = 0; j < a.getNThds(); j++)
     {
-        this->foundSchedule = false;
+        valid[j] = (w[trace_inst->wid].tmask >> j) & 1;
+        addr[j]  = trace_inst->mem_addresses[j];
+        if (valid[j] && first < 0) first = j;
     }
-    else
-    {
-        this->foundSchedule = true;
-    }
-    
+
+    if (first < 0)
+        return;
+
+    // Like VX_mem_unit, the first lane's address selects shared memory
+    bool is_smem = (addr[first] - SHARED_MEM_BASE_ADDR) < SCACHE_SIZE;
+    Cache &cache = is_smem ? smem : dcache;
+    trace_inst->mem_stall_cycles += cache.access(addr, valid, a.getNThds(), trace_inst->is_sw);
+}
+
+void Core::warpScheduler()
+{
+    schedStalled = stalledWarps;
+    int next = sched->pick(readyWarps());
+    this->foundSchedule = (next >= 0);
+    if (foundSchedule) schedule_w = next;
 }
 
 void Core::fetch()
@@ -395,6 +424,10 @@ void Core::fetch()
 
    // D(-1, "Found schedule: " << foundSchedule);
 
+    issuedWarp = -1;
+    frontStall = STALL_NUM_REASONS;
+    fetchStalled = schedStalled;
+
     if ((!inst_in_scheduler.stalled) && (inst_in_fetch.fetch_stall_cycles == 0))
     {
         // CPY_TRACE(inst_in_decode, inst_in_fetch);
@@ -406,6 +439,8 @@ void Core::fetch()
           if (foundSchedule)
           {
               auto active_threads_b = w[schedule_w].activeThreads;
+              issuedWarp = schedule_w;
+              sched->issue(schedule_w);
 
               this->num_instructions = this->num_instructions + w[schedule_w].activeThreads;
               // this->num_instructions++;
@@ -419,34 +454,44 @@ void Core::fetch()
               this->getCacheDelays(&inst_in_fetch);
               
               if (inst_in_fetch.stall_warp) {
-                stallWarp[inst_in_fetch.wid] = true;
+                stalledWarps |= WarpMask(1) << inst_in_fetch.wid;
               }
           }
+          else
+          {
+              ++sched->noReady;
+          }
           warpScheduler();
         }
     }
     else
     {
+        // blocked behind the scheduler slot, else on the icache
+        ++sched->blocked;
+        if (inst_in_scheduler.stalled) {
+            frontStall = schedStall;
+            frontStallPc = inst_in_scheduler.pc;
+        } else {
+            frontStall = STALL_ICACHE;
+            frontStallPc = inst_in_fetch.pc;
+        }
         inst_in_fetch.stalled = false;
         if (inst_in_fetch.fetch_stall_cycles > 0) inst_in_fetch.fetch_stall_cycles--;
     }
 
+#ifdef USE_DEBUG
     printTrace(&inst_in_fetch, "Fetch");
        
-    // #ifdef PRINT_ACTIVE_THREADS
     DPH(3, "active threads:");
-    for (unsigned j = 0; j < w[schedule_w].tmask.size(); ++j) {
-      if (w[schedule_w].activeThreads > j && w[schedule_w].tmask[j]) {
+    for (unsigned j = 0; j < a.getNThds(); ++j) {
+      if (w[schedule_w].activeThreads > j && ((w[schedule_w].tmask >> j) & 1)) {
         DPN(3, " 1");
       } else  {
         DPN(3, " 0");
       }
     }   
     DPN(3, "\n");
-    // #endif  
-
-  // #ifdef PRINT_ACTIVE_THREADS
-  // #endif
+#endif
 }
 
 void Core::decode()
@@ -481,6 +526,7 @@ void Core::load_store()
         if ((inst_in_scheduler.is_lw || inst_in_scheduler.is_sw))
         {
             inst_in_scheduler.stalled = true;
+            schedStall = (inst_in_lsu.mem_stall_cycles > 0) ? STALL_DCACHE : STALL_LSU;
         }
         do_nothing = true;
     }
@@ -520,6 +566,7 @@ void Core::load_store()
             else
             {
                 inst_in_scheduler.stalled = true;
+                schedStall = STALL_SCOREBOARD;
                 // INIT_TRACE(inst_in_lsu);
                 do_nothing = true;
             }
@@ -539,7 +586,18 @@ void Core::load_store()
 void Core::execute_unit()
 {
     bool do_nothing = false;
-    // EXEC is always not busy
+    if (inst_in_exe.exe_stall_cycles > 0)
+    {
+        // a multi-cycle FPU op still holds the unit
+        inst_in_exe.exe_stall_cycles--;
+        if (inst_in_scheduler.valid_inst && !inst_in_scheduler.is_lw && !inst_in_scheduler.is_sw)
+        {
+            inst_in_scheduler.stalled = true;
+            schedStall = STALL_EXE;
+        }
+        return;
+    }
+
     if (inst_in_scheduler.is_lw || inst_in_scheduler.is_sw)
     {
         // Not an execute instruction
@@ -560,6 +618,11 @@ void Core::execute_unit()
             scheduler_srcs_ready = scheduler_srcs_ready && renameTable[inst_in_scheduler.wid][inst_in_scheduler.rs2];
             // cout << "Rename RS2: " << inst_in_scheduler.rs1 << " is " << renameTable[inst_in_scheduler.wid][inst_in_scheduler.rs2] << " wid: " << inst_in_scheduler.wid << '\n';
         }
+
+        if (inst_in_scheduler.rs3 > 0)
+        {
+            scheduler_srcs_ready = scheduler_srcs_ready && renameTable[inst_in_scheduler.wid][inst_in_scheduler.rs3];
+        }
         
         // cout << "About to check vs*\n" << flush;
         if(inst_in_scheduler.vs1 > 0)
@@ -592,6 +655,7 @@ void Core::execute_unit()
         {
             D(3, "Execute: srcs not ready!");
             inst_in_scheduler.stalled = true;
+            schedStall = STALL_SCOREBOARD;
             // INIT_TRACE(inst_in_exe);
             do_nothing = true;
         }
@@ -613,7 +677,7 @@ void Core::writeback()
 
     if (inst_in_wb.stall_warp)
     {
-        stallWarp[inst_in_wb.wid] = false;
+        stalledWarps &= ~(WarpMask(1) << inst_in_wb.wid);
         // release_warp = true;
         // release_warp_num = inst_in_wb.wid;
     } 
@@ -623,7 +687,7 @@ void Core::writeback()
 
     bool serviced_exe = false;
     bool serviced_mem = false;
-    if ((inst_in_exe.rd > 0) || (inst_in_exe.stall_warp))
+    if (((inst_in_exe.rd > 0) || (inst_in_exe.stall_warp)) && (inst_in_exe.exe_stall_cycles == 0))
     {
         CPY_TRACE(inst_in_wb, inst_in_exe);
         INIT_TRACE(inst_in_exe);
@@ -675,7 +739,14 @@ bool Core::running() const {
   return false;
 }
 
-void Core::printStats() const {
+void Core::printStats(ostream &os) const {
+  icache.printStats(os);
+  dcache.printStats(os);
+  smem.printStats(os);
+  os << "barrier: wait_cycles=" << barrier_cycles << endl;
+  if (!functional) sched->printStats(os, num_cycles);
+  if (perf) perf->printSummary(os);
+
   // unsigned long insts = 0;
   // for (unsigned i = 0; i < w.size(); ++i)
   //   insts += w[i].insts;
@@ -687,6 +758,123 @@ void Core::printStats() const {
   // }
 }
 
+void Core::save(CheckpointWriter &w) const {
+  w.put(functional);
+  w.put(renameTable);
+  w.put(vecRenameTable);
+  w.put(foundSchedule);
+  w.put(activeWarps);
+  w.put(stalledWarps);
+  w.put(schedStalled);
+  w.put(barrierWarps);
+  w.put(globalWarps);
+
+  const trace_inst_t *latches[] = {
+    &inst_in_fetch, &inst_in_decode, &inst_in_scheduler,
+    &inst_in_exe, &inst_in_lsu, &inst_in_wb
+  };
+  for (const trace_inst_t *t : latches) w.put(*t);
+
+  w.put(release_warp);
+  w.put(release_warp_num);
+  w.put(interruptEntry);
+  w.put(steps);
+  w.put(num_cycles);
+  w.put(num_instructions);
+  w.put(barrier_cycles);
+  w.putVector(barriers);
+  w.put(globalSeen);
+  w.put(schedule_w);
+
+  icache.save(w);
+  dcache.save(w);
+  smem.save(w);
+
+  w.putString(sched->name());
+  sched->save(w);
+
+  for (const Warp &warp : this->w) warp.save(w);
+  mem.save(w);
+}
+
+void Core::restore(CheckpointReader &r) {
+  bool savedFunctional = functional;
+  r.get(savedFunctional);
+  if (r.ok && savedFunctional != functional) {
+    // The functional model never drains the timing pipeline's latches
+    cerr << "Error: checkpoint taken in " << (savedFunctional ? "functional" : "timing")
+         << " mode\n";
+    r.ok = false;
+    return;
+  }
+
+  r.get(renameTable);
+  r.get(vecRenameTable);
+  r.get(foundSchedule);
+  r.get(activeWarps);
+  r.get(stalledWarps);
+  r.get(schedStalled);
+  r.get(barrierWarps);
+  r.get(globalWarps);
+
+  trace_inst_t *latches[] = {
+    &inst_in_fetch, &inst_in_decode, &inst_in_scheduler,
+    &inst_in_exe, &inst_in_lsu, &inst_in_wb
+  };
+  for (trace_inst_t *t : latches) r.get(*t);
+
+  r.get(release_warp);
+  r.get(release_warp_num);
+  r.get(interruptEntry);
+  r.get(steps);
+  r.get(num_cycles);
+  r.get(num_instructions);
+  r.get(barrier_cycles);
+  r.getVector(barriers);
+  r.get(globalSeen);
+  r.get(schedule_w);
+
+  icache.restore(r);
+  dcache.restore(r);
+  smem.restore(r);
+
+  // A run may switch policies; the saved one's state is then dropped
+  string policy;
+  r.getString(policy);
+  if (policy == sched->name()) {
+    sched->restore(r);
+  } else {
+    unique_ptr<WarpScheduler> saved(makeScheduler(policy, this->w.size()));
+    if (saved) saved->restore(r);
+    else r.ok = false;
+  }
+
+  for (Warp &warp : this->w) warp.restore(r);
+  mem.restore(r);
+}
+
+bool Core::readCounter(Word csrId, Word &value) const {
+  uint64_t count;
+  switch (csrId & ~0x80) {
+  case 0xC00: // cycle
+  case 0xB00: // mcycle
+    count = num_cycles;
+    break;
+  case 0xC02: // instret
+  case 0xB02: // minstret
+    count = num_instructions;
+    break;
+  case 0xC03: // hpmcounter3
+  case 0xB03: // mhpmcounter3
+    count = barrier_cycles;
+    break;
+  default:
+    return false;
+  }
+  value = (csrId & 0x80) ? Word(count >> 32) : Word(count);
+  return true;
+}
+
 Warp::Warp(Core *c, Word id) : 
   core(c), 
   pc(0x80000000), 
@@ -694,54 +882,172 @@ Warp::Warp(Core *c, Word id) :
   id(id), 
   activeThreads(0), 
   shadowActiveThreads(0),
-  reg(0), 
+  fcsr(0),
   pred(0),
+  tmask(1),
+  shadowTmask(1),
   shadowReg(core->a.getNRegs()), 
   shadowPReg(core->a.getNPRegs()),   
+  vl(0),
   VLEN(1024),
   interruptEnable(true),
   shadowInterruptEnable(false),
   supervisorMode(true),  
   shadowSupervisorMode(false),
   spawned(false), 
+  barrierWait(false),
+  barrierId(0),
+  barrierGen(0),
+  barrierSeen(0),
   steps(0), 
   insts(0), 
   loads(0), 
   stores(0)  
 {
   D(3, "Creating a new thread with PC: " << hex << this->pc << '\n');
-  /* Build the register file. */
-  Word regNum(0);
-  for (Word j = 0; j < core->a.getNThds(); ++j) {
-    reg.push_back(vector<Reg<Word> >(0));
-    for (Word i = 0; i < core->a.getNRegs(); ++i) {
-      reg[j].push_back(Reg<Word>(id, regNum++));
-    }
+  vtype.vill = vtype.vediv = vtype.vsew = vtype.vlmul = 0;
+  vreg.resize(VLEN);
+  if (core->a.getNThds() > MAX_THREADS) {
+    cerr << "Error: " << core->a.getNThds() << " threads per warp, at most "
+         << MAX_THREADS << " supported.\n";
+    abort();
+  }
 
+  /* Build the register files. */
+  reg.assign(core->a.getNRegs(), vector<Word>(core->a.getNThds(), 0));
+  freg.assign(core->a.getNRegs(), vector<Word>(core->a.getNThds(), 0));
+
+  // Reg<> drops writes to id 0; number the rest after the GPRs
+  Word regNum(core->a.getNThds() * core->a.getNRegs());
+  for (Word j = 0; j < core->a.getNThds(); ++j) {
     pred.push_back(vector<Reg<bool> >(0));
     for (Word i = 0; i < core->a.getNPRegs(); ++i) {
       pred[j].push_back(Reg<bool>(id, regNum++));
     }
+  }
+}
+
+Word Warp::getCsr(Word csrId) const {
+  switch (csrId) {
+  case 0x001: return fcsr & 0x1f;        // fflags
+  case 0x002: return (fcsr >> 5) & 0x7;  // frm
+  case 0x003: return fcsr;               // fcsr
+  }
+  Word value;
+  if (core->readCounter(csrId, value)) return value;
+  auto it = csr.find(csrId);
+  return (it == csr.end()) ? 0 : it->second;
+}
 
-    bool act = false;
-    if (j == 0) act = true;
-    tmask.push_back(act);
-    shadowTmask.push_back(act);
+void Warp::setCsr(Word csrId, Word value) {
+  switch (csrId) {
+  case 0x001: fcsr = (fcsr & ~0x1f) | (value & 0x1f); return;
+  case 0x002: fcsr = (fcsr & 0x1f) | ((value & 0x7) << 5); return;
+  case 0x003: fcsr = value & 0xff; return;
   }
+  Word counter;
+  if (core->readCounter(csrId, counter)) return; // read-only here
+  csr[csrId] = value;
+}
 
-  Word csrNum(0);
-  for (Word i = 0; i < (1<<12); i++)
-  {
-    csr.push_back(Reg<uint16_t>(id, regNum++));
+void Warp::save(CheckpointWriter &w) const {
+  w.put(pc);
+  w.put(shadowPc);
+  w.put(activeThreads);
+  w.put(shadowActiveThreads);
+  for (auto &r : reg) w.putVector(r);
+  for (auto &r : freg) w.putVector(r);
+  w.put(fcsr);
+  for (auto &lane : pred)
+    for (auto &p : lane) w.put(p.val);
+
+  w.put<uint64_t>(csr.size());
+  for (auto &e : csr) {
+    w.put(e.first);
+    w.put(e.second);
   }
 
-  /* Set initial register contents. */
-  reg[0][0] = (core->a.getNThds()<<(core->a.getWordSize()*8 / 2)) | id;
+  w.put(tmask);
+  w.put(shadowTmask);
+  w.put(domStack);
+  w.putVector(shadowReg);
+  for (bool p : shadowPReg) w.put(p);
+
+  w.put(vtype);
+  w.put(vl);
+  w.put(VLEN);
+  w.putBytes(vreg.raw(), vreg.rawBytes());
+
+  w.put(interruptEnable);
+  w.put(shadowInterruptEnable);
+  w.put(supervisorMode);
+  w.put(shadowSupervisorMode);
+  w.put(spawned);
+  w.put(barrierWait);
+  w.put(barrierId);
+  w.put(barrierGen);
+  w.put(barrierSeen);
+  w.put(steps);
+  w.put(insts);
+  w.put(loads);
+  w.put(stores);
+}
+
+void Warp::restore(CheckpointReader &r) {
+  r.get(pc);
+  r.get(shadowPc);
+  r.get(activeThreads);
+  r.get(shadowActiveThreads);
+  for (auto &v : reg) r.getVector(v);
+  for (auto &v : freg) r.getVector(v);
+  r.get(fcsr);
+  for (auto &lane : pred)
+    for (auto &p : lane) r.get(p.val);
+
+  uint64_t n = 0;
+  r.get(n);
+  csr.clear();
+  for (uint64_t i = 0; r.ok && i < n; ++i) {
+    Word id, value;
+    r.get(id);
+    r.get(value);
+    csr[id] = value;
+  }
+
+  r.get(tmask);
+  r.get(shadowTmask);
+  r.get(domStack);
+  r.getVector(shadowReg);
+  for (Size i = 0; i < shadowPReg.size(); ++i) {
+    bool p = false;
+    r.get(p);
+    shadowPReg[i] = p;
+  }
+
+  r.get(vtype);
+  r.get(vl);
+  Word savedVLEN = 0;
+  r.get(savedVLEN);
+  if (savedVLEN != VLEN) r.ok = false;
+  r.getBytes(vreg.raw(), r.ok ? vreg.rawBytes() : 0);
+
+  r.get(interruptEnable);
+  r.get(shadowInterruptEnable);
+  r.get(supervisorMode);
+  r.get(shadowSupervisorMode);
+  r.get(spawned);
+  r.get(barrierWait);
+  r.get(barrierId);
+  r.get(barrierGen);
+  r.get(barrierSeen);
+  r.get(steps);
+  r.get(insts);
+  r.get(loads);
+  r.get(stores);
 }
 
 void Warp::step(trace_inst_t * trace_inst) {
-  Size fetchPos(0), decPos, wordSize(core->a.getWordSize());
-  vector<Byte> fetchBuffer(wordSize);
+  Size wordSize(core->a.getWordSize());
 
   if (activeThreads == 0) return;
 
@@ -755,47 +1061,92 @@ void Warp::step(trace_inst_t * trace_inst) {
 
   /* Fetch and decode. */
   if (wordSize < sizeof(pc)) pc &= ((1ll<<(wordSize*8))-1);
-  Instruction *inst;
-  bool fetchMore;
-
-  fetchMore = false;
-  // unsigned fetchSize(wordSize - (pc+fetchPos)%wordSize);
-  unsigned fetchSize = 4;
-  fetchBuffer.resize(fetchSize);
-  Word fetched = core->mem.fetch(pc + fetchPos, supervisorMode);
-  writeWord(fetchBuffer, fetchPos, fetchSize, fetched);
-  decPos = 0;
-  inst = core->iDec.decode(fetchBuffer, decPos, trace_inst);
+  Instruction &inst = core->decodeCache.lookup(pc, supervisorMode, trace_inst);
 
   // Update pc
-  pc += decPos;
+  pc += 4;
 
   // Execute
+  ThreadMask lanes = tmask & threadMaskLow(activeThreads);
+
+  inst.executeOn(*this, trace_inst);
+  core->updateActive(id);
+
+  if (core->perf)
+    core->perf->retire(id, trace_inst->pc, lanes, trace_inst->is_lw, trace_inst->is_sw);
+
+  if (core->trace && core->trace->retires) {
+    TraceRecord r;
+    r.cycle       = core->num_cycles;
+    r.pc          = trace_inst->pc;
+    r.tmask       = lanes;
+    r.core        = core->id;
+    r.type        = TRACE_RETIRE;
+    r.stage       = 0;
+    r.wid         = id;
+    r.rd          = trace_inst->rd;
+    r.rs1         = trace_inst->rs1;
+    r.rs2         = trace_inst->rs2;
+    r.fetch_stall = 0;
+    r.mem_stall   = 0;
+    r.flags       = (trace_inst->is_lw ? TRACE_F_LOAD : 0)
+                  | (trace_inst->is_sw ? TRACE_F_STORE : 0)
+                  | (trace_inst->stall_warp ? TRACE_F_STALL_WARP : 0)
+                  | (trace_inst->wspawn ? TRACE_F_WSPAWN : 0);
+    core->trace->push(r);
+  }
 
-  inst->executeOn(*this, trace_inst);
-
- 
   // At Debug Level 3, print debug info after each instruction.
-  // #ifdef USE_DEBUG
-    // if (USE_DEBUG >= 3) {
+#ifdef USE_DEBUG
+    if (USE_DEBUG >= 3) {
       D(3, "Register state:");
-      for (unsigned i = 0; i < reg[0].size(); ++i) {
+      for (unsigned i = 0; i < reg.size(); ++i) {
         D_RAW("  %r" << setfill(' ') << setw(2) << dec << i << ':');
         for (unsigned j = 0; j < (this->activeThreads); ++j) 
-          D_RAW(' ' << setfill('0') << setw(8) << hex << reg[j][i] << setfill(' ') << ' ');
+          D_RAW(' ' << setfill('0') << setw(8) << hex << reg[i][j] << setfill(' ') << ' ');
         D_RAW('(' << shadowReg[i] << ')' << endl);
       }
 
 
       DPH(3, "Thread mask:");
-      for (unsigned i = 0; i < tmask.size(); ++i) DPN(3, " " << tmask[i]);
+      for (unsigned i = 0; i < core->a.getNThds(); ++i) DPN(3, " " << ((tmask >> i) & 1));
       DPN(3, "\n");
+    }
+#endif
+}
 
-    // }
-  // #endif
+bool Warp::barrierWaiting() {
+  if (!barrierWait) return false;
+  if (core->global_barrier->released(barrierId, barrierGen, barrierSeen))
+    barrierWait = false;
+  return barrierWait;
+}
+
+uint64_t GlobalBarrier::arrive(Word id, Word count, uint64_t *seen) {
+  std::lock_guard<std::mutex> lock(mutex);
+  Entry &e = barriers[id];
+  uint64_t generation = e.generation;
+  *seen = releases;
+  if (++e.arrived >= count) {
+    D(3, "Global barrier 0x" << hex << id << dec << " released");
+    e.arrived = 0;
+    ++e.generation;
+    ++releases;
+    cv.notify_all();
+  }
+  return generation;
+}
+
+bool GlobalBarrier::released(Word id, uint64_t generation, uint64_t seen) {
+  // Nothing can have been released unless the release count moved
+  if (releases == seen) return false;
+  std::lock_guard<std::mutex> lock(mutex);
+  return barriers[id].generation != generation;
+}
 
-  // Clean up.
-  delete inst;
+void GlobalBarrier::wait(uint64_t seen) {
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&]() { return releases != seen; });
 }
 
 bool Warp::interrupt(Word r0) {
@@ -803,6 +1154,8 @@ bool Warp::interrupt(Word r0) {
 
 #ifdef EMU_INSTRUMENTATION
   Harp::OSDomain::osDomain->do_int(0, r0);
+#else
+  (void)r0; // x0 is hardwired, so r0 only reaches the instrumentation hook
 #endif
 
   shadowActiveThreads = activeThreads;
@@ -810,15 +1163,15 @@ bool Warp::interrupt(Word r0) {
   shadowInterruptEnable = interruptEnable; /* For traps. */
   shadowSupervisorMode = supervisorMode;
   
-  for (Word i = 0; i < reg[0].size(); ++i) shadowReg[i] = reg[0][i];
+  for (Word i = 0; i < reg.size(); ++i) shadowReg[i] = reg[i][0];
   for (Word i = 0; i < pred[0].size(); ++i) shadowPReg[i] = pred[0][i];
-  for (Word i = 0; i < reg.size(); ++i) tmask[i] = 1;
+  tmask = threadMaskLow(core->a.getNThds());
 
   shadowPc = pc;
   activeThreads = 1;
+  core->updateActive(id);
   interruptEnable = false;
   supervisorMode = true;
-  reg[0][0] = r0;
   pc = core->interruptEntry;
 
   return true;
@@ -830,7 +1183,7 @@ void Warp::printStats() const {
   //      << "Loads : " << loads << endl
   //      << "Stores: " << stores << endl;
 
-  unsigned const grade = reg[0][28];
+  unsigned const grade = reg[28][0];
 
   // if (grade == 1) cout << "GRADE: PASSED\n";
   // else              cout << "GRADE: FAILED "  << (grade >> 1) << "\n";
@@ -0,0 +1,96 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#include <string.h>
+
+#include "include/debug.h"
+#include "include/types.h"
+#include "include/enc.h"
+#include "include/mem.h"
+#include "include/decode_cache.h"
+
+using namespace std;
+using namespace Harp;
+
+DecodeCache::DecodeCache(Decoder &dec, MemoryUnit &mem) :
+  hits(0), misses(0), decoder(dec), mem(mem), lastPage(0), lastBlock(NULL)
+{
+  mem.attachDecodeCache(this);
+}
+
+DecodeCache::~DecodeCache() {
+  mem.detachDecodeCache(this);
+  for (size_t i = 0; i < arena.size(); ++i) delete arena[i];
+}
+
+DecodeCache::Block *DecodeCache::getBlock(Addr page) {
+  unordered_map<Addr, Block *>::iterator it = blocks.find(page);
+  Block *b;
+  if (it != blocks.end()) {
+    b = it->second;
+  } else {
+    b = new Block;
+    memset(b->valid, 0, sizeof(b->valid));
+    arena.push_back(b);
+    blocks[page] = b;
+  }
+  lastPage = page;
+  lastBlock = b;
+  return b;
+}
+
+Instruction &DecodeCache::lookup(Addr pc, bool sup, trace_inst_t *trace_inst) {
+  Addr page = pc >> PAGE_BITS;
+  Block *b = (lastBlock && page == lastPage) ? lastBlock : getBlock(page);
+  Size idx = (pc & (PAGE_SIZE - 1)) >> 2;
+  Entry &e = b->entries[idx];
+
+  if (!b->valid[idx]) {
+    ++misses;
+
+    trace_inst_t t;
+    t.valid_inst = false;
+    t.rs1 = t.rs2 = t.rs3 = t.rd = -1;
+    t.vs1 = t.vs2 = t.vd = -1;
+
+    e.inst = Instruction();
+    decoder.decode(mem.fetch(pc, sup), e.inst, &t);
+
+    e.valid_inst = t.valid_inst;
+    e.rs1 = t.rs1;
+    e.rs2 = t.rs2;
+    e.rs3 = t.rs3;
+    e.rd  = t.rd;
+    e.vs1 = t.vs1;
+    e.vs2 = t.vs2;
+    e.vd  = t.vd;
+
+    b->valid[idx] = true;
+    mem.markCodePage(page);
+  } else {
+    ++hits;
+  }
+
+  trace_inst->valid_inst = e.valid_inst;
+  trace_inst->rs1 = e.rs1;
+  trace_inst->rs2 = e.rs2;
+  trace_inst->rs3 = e.rs3;
+  trace_inst->rd  = e.rd;
+  trace_inst->vs1 = e.vs1;
+  trace_inst->vs2 = e.vs2;
+  trace_inst->vd  = e.vd;
+
+  return e.inst;
+}
+
+void DecodeCache::invalidate(Addr page) {
+  unordered_map<Addr, Block *>::iterator it = blocks.find(page);
+  if (it == blocks.end()) return;
+  D(2, "Decode cache: invalidating code page 0x" << hex << (page << PAGE_BITS));
+  memset(it->second->valid, 0, sizeof(it->second->valid));
+}
+
+void DecodeCache::invalidateAll() {
+  for (size_t i = 0; i < arena.size(); ++i)
+    memset(arena[i]->valid, 0, sizeof(arena[i]->valid));
+}
@@ -15,6 +15,8 @@
 #include "include/archdef.h"
 #include "include/instruction.h"
 
+#include <VX_config.h>
+
 using namespace std;
 using namespace Harp;
 
@@ -89,6 +91,31 @@ static Word signExt(Word w, Size bit, Word mask) {
   return w;
 }
 
+/* OP-FP reads and writes the integer or the float registers depending on
+   func7; move the float ones into their scoreboard range. */
+static void floatTraceRegs(Word func7, trace_inst_t *trace_inst) {
+  bool intDest = false, intSrc = false, unary = false;
+  switch (func7) {
+  case 0x2c:             // FSQRT
+    unary = true;
+    break;
+  case 0x50:             // FEQ/FLT/FLE
+    intDest = true;
+    break;
+  case 0x60:             // FCVT.W[U].S
+  case 0x70:             // FMV.X.W, FCLASS
+    intDest = unary = true;
+    break;
+  case 0x68:             // FCVT.S.W[U]
+  case 0x78:             // FMV.W.X
+    intSrc = unary = true;
+    break;
+  }
+  if (!intDest) trace_inst->rd += TRACE_FREG;
+  if (!intSrc)  trace_inst->rs1 += TRACE_FREG;
+  trace_inst->rs2 = unary ? -1 : trace_inst->rs2 + TRACE_FREG;
+}
+
 Instruction *WordDecoder::decode(const std::vector<Byte> &v, Size &idx, trace_inst_t * trace_inst) {
   Word code(readWord(v, idx, inst_s/8));
 
@@ -97,6 +124,22 @@ Instruction *WordDecoder::decode(const std::vector<Byte> &v, Size &idx, trace_in
 
   Instruction &inst = * new Instruction();  
 
+  bool usedImm = this->decode(code, inst, trace_inst);
+
+  if (haveRefs && usedImm && refMap.find(idx-n/8) != refMap.end()) {
+    Ref *srcRef = refMap[idx-n/8];
+
+    /* Create a new ref tied to this instruction. */
+    // Ref *r = new SimpleRef(srcRef->name, *(Addr*)inst.setSrcImm(),
+    //                        inst.hasRelImm());
+    // inst.setImmRef(*r);
+  }
+
+  return &inst;
+}
+
+bool WordDecoder::decode(Word code, Instruction &inst, trace_inst_t * trace_inst) {
+
   // bool predicated = (code>>(n-1));
   bool predicated = false;
   if (predicated) { inst.setPred((code>>(inst_s-p-1))&pMask); }
@@ -127,6 +170,24 @@ Instruction *WordDecoder::decode(const std::vector<Byte> &v, Size &idx, trace_in
       trace_inst->rs2        = ((code>>shift_rs2)   & reg_mask);
       trace_inst->rd         = ((code>>shift_rd)    & reg_mask);
 
+      if (op == FCI) floatTraceRegs((code>>shift_func7) & func7_mask, trace_inst);
+
+      break;
+    case InstType::R4_TYPE:
+      // rs3 sits in func7's upper five bits, the format in the lower two
+      inst.setDestReg((code>>shift_rd)   & reg_mask);
+      inst.setSrcReg((code>>shift_rs1)   & reg_mask);
+      inst.setSrcReg((code>>shift_rs2)   & reg_mask);
+      inst.setSrcReg((code>>(shift_func7 + 2)) & reg_mask);
+      inst.setFunc3 ((code>>shift_func3) & func3_mask);
+      inst.setFunc7 ((code>>shift_func7) & func7_mask);
+
+      trace_inst->valid_inst = true;
+      trace_inst->rs1        = ((code>>shift_rs1)   & reg_mask) + TRACE_FREG;
+      trace_inst->rs2        = ((code>>shift_rs2)   & reg_mask) + TRACE_FREG;
+      trace_inst->rs3        = ((code>>(shift_func7 + 2)) & reg_mask) + TRACE_FREG;
+      trace_inst->rd         = ((code>>shift_rd)    & reg_mask) + TRACE_FREG;
+
       break;
     case InstType::I_TYPE:
       inst.setDestReg((code>>shift_rd)   & reg_mask);
@@ -273,6 +334,21 @@ Instruction *WordDecoder::decode(const std::vector<Byte> &v, Size &idx, trace_in
           }
         break;
         case Opcode::VL:
+#ifdef EXT_F_ENABLE
+          if (((code>>shift_func3) & func3_mask) == 2) {
+            // FLW
+            inst.setDestReg((code>>shift_rd)   & reg_mask);
+            inst.setSrcReg((code>>shift_rs1)   & reg_mask);
+            inst.setVlsWidth(2);
+            inst.setSrcImm(signExt(code>>shift_i_immed, 12, i_immed_mask));
+            usedImm = true;
+
+            trace_inst->valid_inst = true;
+            trace_inst->rs1        = ((code>>shift_rs1)   & reg_mask);
+            trace_inst->rd         = ((code>>shift_rd)    & reg_mask) + TRACE_FREG;
+            break;
+          }
+#endif
           D(3, "vector load instr");
           inst.setDestReg((code>>shift_rd)   & reg_mask);
           inst.setSrcReg((code>>shift_rs1)   & reg_mask);
@@ -289,6 +365,23 @@ Instruction *WordDecoder::decode(const std::vector<Byte> &v, Size &idx, trace_in
 
         break;
         case Opcode::VS:
+#ifdef EXT_F_ENABLE
+          if (((code>>shift_func3) & func3_mask) == 2) {
+            // FSW
+            inst.setSrcReg((code>>shift_rs1)   & reg_mask);
+            inst.setSrcReg((code>>shift_rs2)   & reg_mask);
+            inst.setVlsWidth(2);
+            imm_bits = (code>>shift_s_b_immed) & func7_mask;
+            inst.setSrcImm(signExt((imm_bits << reg_s) | ((code>>shift_rd) & reg_mask),
+                                   12, s_immed_mask));
+            usedImm = true;
+
+            trace_inst->valid_inst = true;
+            trace_inst->rs1        = ((code>>shift_rs1)   & reg_mask);
+            trace_inst->rs2        = ((code>>shift_rs2)   & reg_mask) + TRACE_FREG;
+            break;
+          }
+#endif
           inst.setVs3((code>>shift_rd)   & reg_mask);
           inst.setSrcReg((code>>shift_rs1)   & reg_mask);
           inst.setVlsWidth((code>>shift_func3)  & func3_mask);
@@ -312,17 +405,8 @@ Instruction *WordDecoder::decode(const std::vector<Byte> &v, Size &idx, trace_in
       std::abort();
   }
 
-  if (haveRefs && usedImm && refMap.find(idx-n/8) != refMap.end()) {
-    Ref *srcRef = refMap[idx-n/8];
-
-    /* Create a new ref tied to this instruction. */
-    // Ref *r = new SimpleRef(srcRef->name, *(Addr*)inst.setSrcImm(),
-    //                        inst.hasRelImm());
-    // inst.setImmRef(*r);
-  }
-
   D(2, "Decoded instr 0x" << hex << code << " into: " << inst);
 
-  return &inst;
+  return usedImm;
 }
 
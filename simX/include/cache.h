@@ -0,0 +1,91 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __CACHE_H
+#define __CACHE_H
+
+#include <vector>
+#include <mutex>
+#include <iostream>
+
+#include "types.h"
+
+namespace Harp {
+  class CheckpointWriter;
+  class CheckpointReader;
+
+  /* Geometry and timing of one cache, mirroring the VX_cache parameters. */
+  struct CacheConfig {
+    const char *name;
+    Size size;        // total capacity in bytes
+    Size line_size;   // bank line size in bytes
+    Size num_banks;
+    Size word_size;
+    Size ways;        // 1 = direct-mapped, as in VX_cache
+    Size mshr_size;   // outstanding misses serviced together (MRVQ entries)
+    Size hit_latency; // cycles to service a hit when accessed from above
+    bool dram_enable; // false for the shared memory, which never misses
+  };
+
+  /* Cache configurations built from the VX_config knobs. */
+  CacheConfig icacheConfig();
+  CacheConfig dcacheConfig();
+  CacheConfig smemConfig();
+  CacheConfig l2cacheConfig();
+  CacheConfig l3cacheConfig();
+
+  /* Native timing model of a banked, set-associative, write-through cache.
+     It only tracks tags; data always lives in RAM. Addresses are split as in
+     VX_cache_config.vh: | tag | set | bank | word | offset |. */
+  class Cache {
+  public:
+    /* next is the level below, or NULL for DRAM. A shared cache (L2/L3) is
+       accessed by several core threads and serialises its lookups. */
+    Cache(const CacheConfig &config, Cache *next = NULL, bool shared = false);
+
+    /* Service one warp request, one address per valid lane. Returns the
+       cycles the request stalls beyond a hit: conflicting lines in the same
+       bank are serialised, and read misses wait for the level below,
+       mshr_size lines at a time. Writes go through without allocating. */
+    Size access(const Addr *addr, const bool *valid, Size n, bool write);
+
+    /* Single line request from the level above; returns its latency. */
+    Size fill(Addr addr, bool write);
+
+    struct Stats {
+      Stats() : reads(0), writes(0), hits(0), misses(0), bank_conflicts(0),
+        evictions(0) {}
+      unsigned long reads, writes, hits, misses, bank_conflicts, evictions;
+    };
+
+    const CacheConfig &getConfig() const { return config; }
+    const Stats &getStats() const { return stats; }
+    void printStats(std::ostream &os = std::cout) const;
+
+    /* Tags, LRU state and statistics, for checkpoints. */
+    void save(CheckpointWriter &) const;
+    void restore(CheckpointReader &);
+
+  private:
+    bool lookup(Addr line, bool allocate);
+    Size nextLatency(Addr line, bool write);
+
+    CacheConfig config;
+    Cache *next;
+    bool shared;
+    std::mutex mutex;
+
+    Size sets, bank_bits, line_bits;
+
+    // tags[(bank * sets + set) * ways + way], 0 marks an empty way
+    std::vector<Addr> tags;
+    std::vector<unsigned long> lru;
+    unsigned long tick;
+
+    std::vector<Size> bank_load;
+
+    Stats stats;
+  };
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+class RAM;
+
+namespace Harp {
+  class Core;
+
+  static const uint32_t CHECKPOINT_MAGIC   = 0x4b435856; // "VXCK"
+  static const uint32_t CHECKPOINT_VERSION = 1;
+
+  /* Simulator state is written field by field in host byte order; vectors
+     are a 64-bit count followed by their elements. Checkpoints are meant to
+     be restored by the same simX build on the same kind of host. */
+  class CheckpointWriter {
+  public:
+    CheckpointWriter(FILE *file) : ok(true), file(file) {}
+
+    void putBytes(const void *p, size_t n) {
+      if (n && fwrite(p, 1, n, file) != n) ok = false;
+    }
+
+    template <typename T> void put(const T &x) { putBytes(&x, sizeof(T)); }
+
+    template <typename T> void putVector(const std::vector<T> &v) {
+      put<uint64_t>(v.size());
+      putBytes(v.data(), v.size() * sizeof(T));
+    }
+
+    void putString(const std::string &s) {
+      put<uint64_t>(s.size());
+      putBytes(s.data(), s.size());
+    }
+
+    bool ok;
+
+  private:
+    FILE *file;
+  };
+
+  class CheckpointReader {
+  public:
+    CheckpointReader(FILE *file) : ok(true), file(file) {}
+
+    void getBytes(void *p, size_t n) {
+      if (!ok || (n && fread(p, 1, n, file) != n)) ok = false;
+    }
+
+    template <typename T> void get(T &x) { getBytes(&x, sizeof(T)); }
+
+    /* A vector whose size is fixed by the architecture; a different size in
+       the checkpoint fails the read. */
+    template <typename T> void getVector(std::vector<T> &v) {
+      uint64_t n = 0;
+      get(n);
+      if (n != v.size()) ok = false;
+      getBytes(v.data(), ok ? n * sizeof(T) : 0);
+    }
+
+    void getString(std::string &s) {
+      uint64_t n = 0;
+      get(n);
+      if (n > 4096) ok = false;
+      s.assign(ok ? n : 0, '\0');
+      if (ok) getBytes(&s[0], n);
+    }
+
+    bool ok;
+
+  private:
+    FILE *file;
+  };
+
+  /* Write the complete state of core (warps, pipeline latches, caches,
+     scheduler, TLB) and the non-zero pages of ram to path. */
+  bool saveCheckpoint(const std::string &path, const Core &core,
+                      const ::RAM &ram);
+
+  /* Load a checkpoint written by saveCheckpoint() into a freshly built core
+     of the same architecture. ram is cleared first. */
+  bool restoreCheckpoint(const std::string &path, Core &core, ::RAM &ram);
+}
+
+#endif
@@ -6,23 +6,29 @@
 
 #include <string>
 #include <vector>
-#include <stack>
+#include <iostream>
+#include <cstdlib>
 #include <map>
+#include <unordered_map>
 #include <set>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
 
 #include "types.h"
 #include "archdef.h"
 #include "enc.h"
 #include "mem.h"
+#include "decode_cache.h"
+#include "cache.h"
+#include "vreg.h"
+#include "trace_sink.h"
+#include "perf.h"
+#include "scheduler.h"
+#include "checkpoint.h"
 #include "debug.h"
 
-#include "Vcache_simX.h"
-#include "verilated.h"
-
-#ifdef VCD_OUTPUT
-#include <verilated_vcd_c.h>
-#endif
-
 
 #include "trace.h"
 
@@ -64,31 +70,59 @@ namespace Harp {
 #endif
   };
 
+  /* Thread masks are bit words: bit t is thread t. */
+  typedef uint32_t ThreadMask;
+  static const Size MAX_THREADS = 32;
+
+  /* Mask of threads [0, n). */
+  inline ThreadMask threadMaskLow(Size n) {
+    return (n >= MAX_THREADS) ? ~ThreadMask(0) : (ThreadMask(1) << n) - 1;
+  }
+  inline Size threadCount(ThreadMask m) { return __builtin_popcount(m); }
+  inline Size firstThread(ThreadMask m) { return __builtin_ctz(m); }
+
   // Entry in the IPDOM Stack
   struct DomStackEntry {
-    DomStackEntry(
-      unsigned p, const std::vector<std::vector<Reg<Word> > >& m,
-      std::vector<bool> &tm, Word pc
-    ): pc(pc), fallThrough(false), uni(false)
-    {
-      std::cout << "DomStackEntry TMASK: ";
-      for (unsigned i = 0; i < m.size(); ++i)
-      {
-        std::cout << " " << (!bool(m[i][p]) && tm[i]);
-        tmask.push_back(!bool(m[i][p]) && tm[i]);
-      }
-      std::cout << "\n";
-    }
+    DomStackEntry() : tmask(0), pc(0), fallThrough(true), uni(false) {}
 
-    DomStackEntry(const std::vector<bool> &tmask):
-      tmask(tmask), fallThrough(true), uni(false) {}
+    DomStackEntry(ThreadMask tmask, Word pc):
+      tmask(tmask), pc(pc), fallThrough(false), uni(false) {}
 
-    std::vector<bool> tmask;   
+    DomStackEntry(ThreadMask tmask):
+      tmask(tmask), pc(0), fallThrough(true), uni(false) {}
+
+    ThreadMask tmask;
     Word pc;
     bool fallThrough;
     bool uni;    
   };
 
+  /* IPDOM stack with storage inside the warp. A divergent split pushes two
+     entries and a uniform one pushes one, so this covers splits nested as
+     deep as the RTL's stack (2 * NUM_THREADS levels). */
+  class DomStack {
+  public:
+    static const Size DEPTH = 4 * MAX_THREADS;
+
+    DomStack() : n(0) {}
+
+    bool empty() const { return n == 0; }
+    DomStackEntry &top() { return entries[n - 1]; }
+    void pop() { --n; }
+
+    void push(const DomStackEntry &e) {
+      if (n == DEPTH) {
+        std::cerr << "Error: IPDOM stack overflow\n";
+        std::abort();
+      }
+      entries[n++] = e;
+    }
+
+  private:
+    DomStackEntry entries[DEPTH];
+    Size n;
+  };
+
   struct vtype
   {
     int vill;
@@ -99,18 +133,63 @@ namespace Harp {
 
   class Warp;
 
+  /* Barriers shared by all the cores of a device. A barrier whose id has the
+     MSB set is global: it releases once the requested number of warps, counted
+     across all cores, have arrived. */
+  class GlobalBarrier {
+  public:
+    GlobalBarrier() : releases(0) {}
+
+    /* Register a warp's arrival. Returns the barrier generation the warp
+       waits on and the release count it observed. */
+    uint64_t arrive(Word id, Word count, uint64_t *seen);
+    bool released(Word id, uint64_t generation, uint64_t seen);
+
+    /* Block the calling host thread until a barrier is released after the
+       release count seen. */
+    void wait(uint64_t seen);
+
+    std::atomic<uint64_t> releases;
+
+  private:
+    struct Entry {
+      Entry() : arrived(0), generation(0) {}
+      Word arrived;
+      uint64_t generation;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<Word, Entry> barriers;
+  };
+
   class Core {
   public:
-    Core(const ArchDef &a, Decoder &d, MemoryUnit &mem, Word id=0);
+    Core(const ArchDef &a, Decoder &d, MemoryUnit &mem, Word id=0,
+         Word num_cores=1, GlobalBarrier *global_barrier=nullptr,
+         Cache *next_level=nullptr);
 
-    Vcache_simX   * cache_simulator;
-    VerilatedVcdC * m_trace;
+    // Timing models; next_level is the shared L2/L3, or NULL for DRAM
+    Cache icache;
+    Cache dcache;
+    Cache smem;
 
-    bool renameTable[32][32];
+    bool renameTable[32][64]; // [wid][x0-x31, f0-f31]
     bool vecRenameTable[32];
-    bool stallWarp[32];
     bool foundSchedule;
 
+    /* Scheduler state as warp masks, so the policy finds the next ready
+       warp with mask arithmetic instead of a rescan.
+       activeWarps mirrors activeThreads > 0 and is kept current through
+       updateActive(); stalledWarps holds the warps waiting for a control
+       instruction to write back; barrierWarps those parked on a barrier,
+       globalWarps the subset parked on a global one. */
+    WarpMask activeWarps, stalledWarps, barrierWarps, globalWarps;
+    void updateActive(Word wid);
+    WarpMask readyWarps() const {
+      return activeWarps & ~stalledWarps & ~barrierWarps;
+    }
+
     trace_inst_t inst_in_fetch;
     trace_inst_t inst_in_decode;
     trace_inst_t inst_in_scheduler;
@@ -125,7 +204,13 @@ namespace Harp {
     bool running() const;
 
     void getCacheDelays(trace_inst_t *);
+
+    /* Fetch-stage warp scheduling; loose round robin unless setScheduler()
+       picks another policy (see makeScheduler()). Returns false for an
+       unknown policy. Unused in functional mode. */
     void warpScheduler();
+    bool setScheduler(const std::string &policy);
+    std::unique_ptr<WarpScheduler> sched;
     void fetch();
     void decode();
     void scheduler();
@@ -134,20 +219,71 @@ namespace Harp {
     void writeback();
 
     void step();
-
-    void printStats() const;
+    void functionalStep();
+    void waitGlobalBarrier();
+
+    /* Arrival of warp wid at barrier id (vx_barrier). The barrier releases
+       once count warps have arrived; ids with the MSB set are global across
+       the cores of a device. */
+    void barrier(Word wid, Word id, Word count);
+    void pollGlobalBarrier();
+
+    void printStats(std::ostream &os = std::cout) const;
+
+    /* Complete core state for checkpoints; see checkpoint.h. The decode
+       cache is rebuilt on demand and profiling/tracing restart empty.
+       restore() fails a checkpoint taken in the other simulation mode. */
+    void save(CheckpointWriter &) const;
+    void restore(CheckpointReader &);
+
+    /* Machine counter CSRs (cycle, instret, their m* aliases and _H upper
+       halves), read live from num_cycles/num_instructions; hpmcounter3
+       counts barrier_cycles. Returns false for any other CSR. */
+    bool readCounter(Word csrId, Word &value) const;
+
+    /* Binary tracing to sink, off while trace is null. */
+    void setTrace(TraceSink *sink);
+    void traceStages();
+    std::unique_ptr<TraceWriter> trace;
+
+    /* Performance counters, off while perf is null. issuedWarp and
+       frontStall record this cycle's fetch for countCycle(). schedStalled
+       is stalledWarps as the last warpScheduler() pick saw it and
+       fetchStalled the same for the pick this cycle's fetch issued from, so
+       a warp released after that pick is still counted as control-stalled. */
+    void enableProfile();
+    void countCycle();
+    std::unique_ptr<PerfCounters> perf;
+    int issuedWarp;
+    StallReason frontStall, schedStall;
+    Word frontStallPc;
+    WarpMask schedStalled, fetchStalled;
+
+    /* Functional mode executes every active warp once per step and skips
+       the timing pipeline and the cache model entirely. */
+    bool functional;
+    trace_inst_t inst_functional;
     
     const ArchDef &a;
     Decoder &iDec;
     MemoryUnit &mem;
+    DecodeCache decodeCache;
 
     Word interruptEntry;
 
+    Word id;
+    Word num_cores;
+    GlobalBarrier *global_barrier;
+
     unsigned long steps;
     unsigned long num_cycles;
     unsigned long num_instructions;
+    unsigned long barrier_cycles; // warp-cycles spent parked on a barrier
     std::vector<Warp> w;
-    std::map<Word, std::set<Warp *> > b; // Barriers
+
+    /* Local barriers: the warps parked on each of the NUM_BARRIERS. */
+    std::vector<WarpMask> barriers;
+    uint64_t globalSeen; // global_barrier->releases at the last poll
     int schedule_w;
   };
 
@@ -158,6 +294,9 @@ namespace Harp {
     void step(trace_inst_t *);
     bool interrupt(Word r0);
     bool running() const { return activeThreads; }
+    bool barrierWaiting();
+    void save(CheckpointWriter &) const;
+    void restore(CheckpointReader &);
 #ifdef EMU_INSTRUMENTATION
     bool getSupervisorMode() const { return supervisorMode; }
 #endif
@@ -176,12 +315,20 @@ namespace Harp {
 
     Word pc, shadowPc, id;
     Size activeThreads, shadowActiveThreads;
-    std::vector<std::vector<Reg<Word> > > reg;
+    /* Register file in [reg][lane] order: reg[r][t] is thread t's x(r), so
+       one register across the warp is contiguous. */
+    std::vector<std::vector<Word> > reg;
+    std::vector<std::vector<Word> > freg; // RV32F, same layout
+    Word fcsr;                            // frm (7:5) and fflags (4:0)
     std::vector<std::vector<Reg<bool> > > pred;
-    std::vector<Reg<uint16_t> > csr;
+    /* Sparse CSR file: only CSRs written by the program are stored, every
+       other CSR reads as zero. */
+    std::unordered_map<Word, Word> csr;
+    Word getCsr(Word csrId) const;
+    void setCsr(Word csrId, Word value);
 
-    std::vector<bool> tmask, shadowTmask;
-    std::stack<DomStackEntry> domStack;
+    ThreadMask tmask, shadowTmask;
+    DomStack domStack;
 
     std::vector<Word> shadowReg;
     std::vector<bool> shadowPReg;
@@ -191,12 +338,17 @@ namespace Harp {
     int vl;    //both of them are XLEN WIDE
     Word VLEN; //Total vector length
 
-    std::vector<std::vector<Reg<char*>>> vreg; // 32 vector registers
+    VRegFile vreg; // 32 vector registers
 
     bool interruptEnable, shadowInterruptEnable;
     bool supervisorMode, shadowSupervisorMode;
     bool spawned;
 
+    // Global barrier the warp is parked on, if any
+    bool barrierWait;
+    Word barrierId;
+    uint64_t barrierGen, barrierSeen;
+
     unsigned long steps, insts, loads, stores;
     
     friend class Instruction;
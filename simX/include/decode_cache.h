@@ -0,0 +1,66 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __DECODE_CACHE_H
+#define __DECODE_CACHE_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "types.h"
+#include "instruction.h"
+#include "trace.h"
+
+namespace Harp {
+  class Decoder;
+  class MemoryUnit;
+
+  /* PC-indexed cache of pre-decoded instructions. Entries live in a flat
+     arena of page-sized blocks so a hit costs one map lookup per page change
+     and never touches the heap. MemoryUnit::write() drops a page's entries
+     whenever that page is overwritten. */
+  class DecodeCache {
+  public:
+    static const Size PAGE_BITS = 12;
+    static const Size PAGE_SIZE = 1 << PAGE_BITS;
+
+    /* Decode fields captured alongside each instruction and replayed into
+       the pipeline trace on a hit. */
+    struct Entry {
+      Instruction inst;
+      bool valid_inst;
+      int rs1, rs2, rs3, rd;
+      int vs1, vs2, vd;
+    };
+
+    DecodeCache(Decoder &dec, MemoryUnit &mem);
+    ~DecodeCache();
+
+    /* Return the decoded instruction at pc, decoding and caching it on a
+       miss, and fill the decoder fields of trace_inst. */
+    Instruction &lookup(Addr pc, bool sup, trace_inst_t *trace_inst);
+
+    void invalidate(Addr page);
+    void invalidateAll();
+
+    unsigned long hits, misses;
+
+  private:
+    struct Block {
+      Entry entries[PAGE_SIZE / 4];
+      bool  valid[PAGE_SIZE / 4];
+    };
+
+    Block *getBlock(Addr page);
+
+    Decoder &decoder;
+    MemoryUnit &mem;
+
+    std::vector<Block *> arena;
+    std::unordered_map<Addr, Block *> blocks;
+    Addr lastPage;
+    Block *lastBlock;
+  };
+}
+
+#endif
@@ -40,6 +40,9 @@ namespace Harp {
     void clearRefs() { refMap.clear(); }
     virtual Instruction *decode(const std::vector<Byte> &v, Size &n, trace_inst_t * trace_inst) = 0;
     virtual Instruction *decode(const std::vector<Byte> &v, Size &n) = 0;
+    /* Decode a single word into an existing instruction. Returns true if
+       the instruction carries an immediate. */
+    virtual bool decode(Word code, Instruction &inst, trace_inst_t * trace_inst) = 0;
     void decodeChunk(TextChunk &dest, const DataChunk &src);
   protected:
     bool haveRefs;
@@ -50,6 +53,7 @@ namespace Harp {
   public:
     WordDecoder(const ArchDef &);    
     virtual Instruction *decode(const std::vector<Byte> &v, Size &n, trace_inst_t * trace_inst);
+    virtual bool decode(Word code, Instruction &inst, trace_inst_t * trace_inst);
     virtual Instruction *decode(const std::vector<Byte> &v, Size &n) {
       printf("Not implemented\n");
       return nullptr;
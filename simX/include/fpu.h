@@ -0,0 +1,127 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __FPU_H
+#define __FPU_H
+
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <fenv.h>
+
+#include "types.h"
+
+namespace Harp {
+  /* RV32F on the host FPU. Values travel as raw bit patterns in Word; the
+     host rounding mode and exception flags stand in for frm and fflags, so
+     the simulator must be built with -frounding-math. */
+  namespace FPU {
+    enum RoundingMode { RNE = 0, RTZ = 1, RDN = 2, RUP = 3, RMM = 4, DYN = 7 };
+
+    enum Flags { NX = 1 << 0, UF = 1 << 1, OF = 1 << 2, DZ = 1 << 3, NV = 1 << 4 };
+
+    static const Word CANONICAL_NAN = 0x7fc00000;
+
+    inline float toFloat(Word w) { float f; memcpy(&f, &w, sizeof(f)); return f; }
+    inline Word toWord(float f) { Word w; memcpy(&w, &f, sizeof(w)); return w; }
+
+    inline bool isNaN(Word a)  { return (a & 0x7fffffff) > 0x7f800000; }
+    inline bool isSNaN(Word a) { return isNaN(a) && !(a & 0x00400000); }
+
+    /* Result of an arithmetic op; RISC-V returns the canonical NaN rather
+       than propagating payloads. */
+    inline Word result(float f) {
+      Word w = toWord(f);
+      return isNaN(w) ? CANONICAL_NAN : w;
+    }
+
+    /* Host rounding mode and a clean set of exception flags for the lanes
+       of one instruction. rm is resolved (not DYN); RMM has no host mode
+       and rounds to nearest even except in the conversions to integer. */
+    class Scope {
+    public:
+      Scope(Word rm) : saved(fegetround()) {
+        static const int host[] = {
+          FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD, FE_TONEAREST
+        };
+        fesetround(rm <= RMM ? host[rm] : FE_TONEAREST);
+        feclearexcept(FE_ALL_EXCEPT);
+      }
+      ~Scope() { fesetround(saved); }
+
+      /* fflags raised since construction. */
+      Word flags() const {
+        int e = fetestexcept(FE_ALL_EXCEPT);
+        return ((e & FE_INEXACT)   ? NX : 0) | ((e & FE_UNDERFLOW) ? UF : 0)
+             | ((e & FE_OVERFLOW)  ? OF : 0) | ((e & FE_DIVBYZERO) ? DZ : 0)
+             | ((e & FE_INVALID)   ? NV : 0);
+      }
+
+    private:
+      int saved;
+    };
+
+    inline void raise(int e) { feraiseexcept(e); }
+
+    /* FMIN/FMAX: a NaN operand yields the other one, -0 orders below +0. */
+    inline Word minMax(Word a, Word b, bool max) {
+      if (isSNaN(a) || isSNaN(b)) raise(FE_INVALID);
+      if (isNaN(a) && isNaN(b)) return CANONICAL_NAN;
+      if (isNaN(a)) return b;
+      if (isNaN(b)) return a;
+      float fa = toFloat(a), fb = toFloat(b);
+      if (fa == fb) return max ? (a & b) : (a | b); // signed zeros
+      return ((fa < fb) != max) ? a : b;
+    }
+
+    /* FEQ (quiet) and FLT/FLE (signaling). */
+    inline Word compare(Word a, Word b, Word op) {
+      if (isNaN(a) || isNaN(b)) {
+        if (op != 2 || isSNaN(a) || isSNaN(b)) raise(FE_INVALID);
+        return 0;
+      }
+      float fa = toFloat(a), fb = toFloat(b);
+      switch (op) {
+      case 0:  return fa <= fb;
+      case 1:  return fa < fb;
+      default: return fa == fb;
+      }
+    }
+
+    /* FCVT.W[U].S: round per rm, saturate and flag NV when out of range. */
+    inline Word toInt(Word a, bool isUnsigned, Word rm) {
+      if (isNaN(a)) {
+        raise(FE_INVALID);
+        return isUnsigned ? 0xffffffff : 0x7fffffff;
+      }
+      float f = toFloat(a);
+      float r = (rm == RMM) ? roundf(f) : nearbyintf(f);
+      double lo = isUnsigned ? 0.0 : -2147483648.0;
+      double hi = isUnsigned ? 4294967296.0 : 2147483648.0;
+      if (r < lo || r >= hi) {
+        raise(FE_INVALID);
+        if (isUnsigned) return (f < 0) ? 0 : 0xffffffff;
+        return (f < 0) ? 0x80000000 : 0x7fffffff;
+      }
+      if (r != f) raise(FE_INEXACT);
+      return isUnsigned ? Word(r) : Word(int32_t(r));
+    }
+
+    /* FCLASS.S bit index. */
+    inline Word classify(Word a) {
+      bool neg = a >> 31;
+      Word exp = (a >> 23) & 0xff, man = a & 0x7fffff;
+      if (exp == 0xff) {
+        if (man == 0) return neg ? 1 << 0 : 1 << 7;
+        return (man & 0x400000) ? 1 << 9 : 1 << 8;
+      }
+      if (exp == 0) {
+        if (man == 0) return neg ? 1 << 3 : 1 << 4;
+        return neg ? 1 << 2 : 1 << 5;
+      }
+      return neg ? 1 << 1 : 1 << 6;
+    }
+  }
+}
+
+#endif
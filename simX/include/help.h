@@ -20,7 +20,24 @@ namespace HarpTools {
                   "  -a, --arch <arch string> Architecture string\n"
                   "  -s, --stats              Print stats on exit.\n"
                   "  -b, --basic              Disable virtual memory.\n"
-                  "  -i, --batch              Disable console input.\n",
+                  "  -f, --functional         Functional mode: no timing "
+                    "pipeline or cache model.\n"
+                  "  -i, --batch              Disable console input.\n"
+                  "  -T, --trace <filename>   Write a binary trace (see "
+                    "trace_decode.run).\n"
+                  "  -e, --trace-events <list> Traced events: stage, "
+                    "retire (default both).\n"
+                  "  -p, --profile <prefix>   Write performance counters to "
+                    "<prefix>.json and a per-PC profile to <prefix>.prof.\n"
+                  "  -S, --scheduler <policy> Warp scheduler: lrr (default), "
+                    "gto, twolevel[:<group size>].\n"
+                  "  --checkpoint-at <cycle>  Save the simulator state after "
+                    "<cycle> cycles.\n"
+                  "  --checkpoint <filename>  Checkpoint file (default "
+                    "simX.ckpt).\n"
+                  "  --restore <filename>     Resume from a checkpoint instead "
+                    "of loading -c.\n"
+                  "  Long options also take --name=value.\n",
       *asmHelp = "HARP Assembler command line arguments:\n"
                   "  -a, --arch <arch string>\n"
                   "  -o, --output <filename>\n",
@@ -5,6 +5,7 @@
 #define __INSTRUCTION_H
 
 #include <map>
+#include <vector>
 #include <iostream>
 #include <math.h>
 
@@ -32,11 +33,16 @@ namespace Harp {
       PJ_INST  = 0x7b,
       GPGPU    = 0x6b,
       VSET_ARITH = 0x57,
-      VL       = 0x7,
-      VS       = 0x27,
+      VL       = 0x7,  // also FLW (width 2)
+      VS       = 0x27, // also FSW (width 2)
+      FCI      = 0x53, // OP-FP: compute, compare, convert, move
+      FMADD    = 0x43,
+      FMSUB    = 0x47,
+      FMNMSUB  = 0x4b,
+      FMNMADD  = 0x4f,
    };
 
-  enum InstType { N_TYPE, R_TYPE, I_TYPE, S_TYPE, B_TYPE, U_TYPE, J_TYPE, V_TYPE};
+  enum InstType { N_TYPE, R_TYPE, I_TYPE, S_TYPE, B_TYPE, U_TYPE, J_TYPE, V_TYPE, R4_TYPE};
 
   // We build a table of instruction information out of this.
   struct InstTableEntry_t {
@@ -65,7 +71,12 @@ namespace Harp {
     {Opcode::GPGPU,      {"gpgpu" , false, false, false, false, InstType::R_TYPE }},
     {Opcode::VSET_ARITH, {"vsetvl" , false, false, false, false, InstType::V_TYPE }}, 
     {Opcode::VL,         {"vl" , false, false, false, false, InstType::V_TYPE }}, 
-    {Opcode::VS,         {"vs" , false, false, false, false, InstType::V_TYPE }}  
+    {Opcode::VS,         {"vs" , false, false, false, false, InstType::V_TYPE }},
+    {Opcode::FCI,        {"fci"    , false, false, false, false, InstType::R_TYPE }},
+    {Opcode::FMADD,      {"fmadd"  , false, false, false, false, InstType::R4_TYPE }},
+    {Opcode::FMSUB,      {"fmsub"  , false, false, false, false, InstType::R4_TYPE }},
+    {Opcode::FMNMSUB,    {"fnmsub" , false, false, false, false, InstType::R4_TYPE }},
+    {Opcode::FMNMADD,    {"fnmadd" , false, false, false, false, InstType::R4_TYPE }}
   };
 
   static const Size MAX_REG_SOURCES(3);
@@ -143,6 +154,15 @@ namespace Harp {
     bool hasRelImm() const { return (*(instTable.find(op))).second.relAddress; }
 
   private:
+    /* RVV arithmetic, load and store for the warp's current SEW. Scalar
+       operands and base addresses come from lane t. */
+    void executeVector(Warp &warp, Size t, trace_inst_t *);
+    template <typename U, typename S>
+    void executeVector(Warp &warp, Size t, trace_inst_t *);
+
+    /* RV32F: FLW/FSW, OP-FP and the fused multiply-adds. */
+    void executeFloat(Warp &warp, trace_inst_t *);
+
     bool predicated;
     RegNum pred;
     Opcode op;
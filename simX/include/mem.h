@@ -8,11 +8,18 @@
 #include <vector>
 #include <queue>
 #include <map>
+#include <string.h>
 // #include <pthread.h>
 
+#include <ram.h>
+
 #include "types.h"
 
 namespace Harp {
+  class DecodeCache;
+  class CheckpointWriter;
+  class CheckpointReader;
+
   void *consoleInputThread(void *);
   struct BadAddress {};
 
@@ -108,13 +115,22 @@ namespace Harp {
   class MemoryUnit {
   public:
     MemoryUnit(Size pageSize, Size addrBytes, bool disableVm = false) : 
-      pageSize(pageSize), addrBytes(addrBytes), ad(), disableVm(disableVm)
+      pageSize(pageSize), addrBytes(addrBytes), ad(), disableVm(disableVm),
+      codePages(CODE_PAGE_WORDS, 0)
     {
       if (!disableVm)
         tlb[0] = TLBEntry(0, 077);
     }
     void attach(MemDevice &m, Addr base);
 
+    /* Decode caches register here so that writes to pages holding cached
+       code invalidate them. Pages are in units of DecodeCache::PAGE_SIZE. */
+    void attachDecodeCache(DecodeCache *dc);
+    void detachDecodeCache(DecodeCache *dc);
+    void markCodePage(Addr page) {
+      codePages[page >> 6] |= (1ull << (page & 63));
+    }
+
     //Size wordSize();
     struct PageFault { 
       PageFault(Addr a, bool nf) : faultAddr(a), notFound(nf) {}
@@ -128,7 +144,11 @@ namespace Harp {
     void write(Addr, Word, bool sup, Size);
     void tlbAdd(Addr virt, Addr phys, Word flags);
     void tlbRm(Addr va);
-    void tlbFlush() { tlb.clear(); }
+    void tlbFlush() { tlb.clear(); invalidateCode(); }
+
+    /* The TLB, for checkpoints; memory contents are saved separately. */
+    void save(CheckpointWriter &) const;
+    void restore(CheckpointReader &);
 
 #ifdef EMU_INSTRUMENTATION
     Addr virtToPhys(Addr va);
@@ -166,59 +186,20 @@ namespace Harp {
     TLBEntry tlbLookup(Addr vAddr, Word flagMask);    
 
     bool disableVm;
+
+    static const Size CODE_PAGE_WORDS = (1ull << 20) / 64;
+    std::vector<uint64_t> codePages;
+    std::vector<DecodeCache *> decodeCaches;
+    void invalidateCode();
   };
 
-  class RAM : public MemDevice {
+  /* Device memory backed by the flat, mmap-reserved RAM shared with the RTL
+     simulators. Pages are committed by the OS on first touch, so several
+     core threads can access it without any locking. */
+  class RAM : public MemDevice, public ::RAM {
   public:
-      uint8_t* mem[1 << 12];
-
-      RAM(){
-          for(uint32_t i = 0;i < (1 << 12);i++) 
-            mem[i] = NULL;
-      }
-      ~RAM(){
-          for(uint32_t i = 0;i < (1 << 12);i++) 
-            if(mem[i]) 
-              delete [] mem[i];
-      }
-
-      void clear(){
-          for(uint32_t i = 0;i < (1 << 12);i++)
-          {
-              if(mem[i])
-              { 
-                  delete mem[i];
-                  mem[i] = NULL;
-              }
-          }
-      }
-
-      uint8_t* get(uint32_t address){
-
-          if(mem[address >> 20] == NULL) {
-              uint8_t* ptr = new uint8_t[1024*1024];
-              for(uint32_t i = 0;i < 1024*1024;i+=4) {
-                  ptr[i + 0] = 0xaa;
-                  ptr[i + 1] = 0xbb;
-                  ptr[i + 2] = 0xcc;
-                  ptr[i + 3] = 0xdd;
-              }
-              mem[address >> 20] = ptr;
-          }
-          return &mem[address >> 20][address & 0xFFFFF];
-      }
-
-      void read(uint32_t address,uint32_t length, uint8_t *data){
-          for(unsigned i = 0;i < length;i++){
-              data[i] = (*this)[address + i];
-          }
-      }
-
-      void write(uint32_t address,uint32_t length, uint8_t *data){
-          for(unsigned i = 0;i < length;i++){
-              (*this)[address + i] = data[i];
-          }
-      }
+      using ::RAM::read;
+      using ::RAM::write;
 
       virtual Size size() const { return -1; }
 
@@ -230,80 +211,26 @@ namespace Harp {
           this->read(block_number, bytes_num, data);
       }
 
+      // bounds-checked, a word at the top of the address space would
+      // run past the end of the mapping
       void getWord(uint32_t address, uint32_t * data)
       {
-          data[0] = 0;
-
-          uint8_t first  = *get(address + 0);
-          uint8_t second = *get(address + 1);
-          uint8_t third  = *get(address + 2);
-          uint8_t fourth = *get(address + 3);
-
-
-          // std::cout << std::hex;
-          // std::cout << "RAM: READING ADDRESS " << address + 0 << " DATA: " << (uint32_t) first << "\n";
-          // std::cout << "RAM: READING ADDRESS " << address + 1 << " DATA: " << (uint32_t) second << "\n";
-          // std::cout << "RAM: READING ADDRESS " << address + 2 << " DATA: " << (uint32_t) third << "\n";
-          // std::cout << "RAM: READING ADDRESS " << address + 3 << " DATA: " << (uint32_t) fourth << "\n";
-
-          data[0] = (data[0] << 0) | fourth;
-          data[0] = (data[0] << 8) | third;
-          data[0] = (data[0] << 8) | second;
-          data[0] = (data[0] << 8) | first;
-          // data[0] = (data[0] << 0) | first;
-          // data[0] = (data[0] << 8) | second;
-          // data[0] = (data[0] << 8) | third;
-          // data[0] = (data[0] << 8) | fourth;
-
-          // std::cout << "FINAL DATA: " << data[0] << "\n";
-
+          this->read(address, 4, (uint8_t*)data);
       }
 
       void writeWord(uint32_t address, uint32_t * data)
       {
-          uint32_t data_to_write = *data;
-
-          uint32_t byte_mask = 0xFF;
-
-          for (int i = 0; i < 4; i++)
-          {
-              // std::cout << "RAM: DATA TO WRITE " << data_to_write << "\n";
-              // std::cout << "RAM: DATA TO MASK  " << byte_mask << "\n";
-              // std::cout << "RAM: WRITING ADDRESS " << address + i << " DATA: " << (data_to_write & byte_mask) << "\n";
-              (*this)[address + i] = data_to_write & byte_mask;
-              data_to_write        = data_to_write >> 8;
-          }
+          this->write(address, 4, (const uint8_t*)data);
       }
 
       void writeHalf(uint32_t address, uint32_t * data)
       {
-          uint32_t data_to_write = *data;
-
-          uint32_t byte_mask = 0xFF;
-
-          for (int i = 0; i < 2; i++)
-          {
-              // std::cout << "RAM: DATA TO WRITE " << data_to_write << "\n";
-              // std::cout << "RAM: DATA TO MASK  " << byte_mask << "\n";
-              // std::cout << "RAM: WRITING ADDRESS " << address + i << " DATA: " << (data_to_write & byte_mask) << "\n";
-              (*this)[address + i] = data_to_write & byte_mask;
-              data_to_write        = data_to_write >> 8;
-          }
+          this->write(address, 2, (const uint8_t*)data);
       }
 
       void writeByte(uint32_t address, uint32_t * data)
       {
-          uint32_t data_to_write = *data;
-
-          uint32_t byte_mask = 0xFF;
-
-          (*this)[address] = data_to_write & byte_mask;
-          data_to_write    = data_to_write >> 8;
-
-      }
-
-      uint8_t& operator [](uint32_t address) {
-          return *get(address);
+          *this->get(address) = (uint8_t) *data;
       }
 
       virtual void write(Addr addr, Word w)
@@ -316,19 +243,17 @@ namespace Harp {
       {
           uint32_t w;
           getWord(addr, &w);
-          // std::cout << "RAM: read -> " << w << " at addr: " << addr << "\n";
           return (Word) w;
       }
 
       virtual Byte *base()
       {
-          return (Byte *) this->get(0);
+          return ::RAM::base();
       }
 
   // MEMORY UTILS
 
   void loadHexImpl(std::string path); 
-
   };
 }
 
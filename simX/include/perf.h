@@ -0,0 +1,91 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __PERF_H
+#define __PERF_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+
+#include "types.h"
+
+namespace Harp {
+  /* Why a running warp did not issue in a cycle. The pipeline reasons
+     (scoreboard through exe) block fetch for every warp of the core. */
+  enum StallReason {
+    STALL_SCOREBOARD, // source register not written back yet (renameTable)
+    STALL_LSU,        // LSU holding its instruction for the writeback port
+    STALL_ICACHE,     // instruction fetch miss
+    STALL_DCACHE,     // LSU waiting on a data access
+    STALL_EXE,        // execute unit busy with a multi-cycle FPU op
+    STALL_BARRIER,    // parked on a barrier
+    STALL_CONTROL,    // waiting for a branch/tmc/split/barrier to write back
+    STALL_ISSUE,      // ready, another warp was scheduled
+    STALL_NUM_REASONS
+  };
+
+  extern const char *stallReasonNames[STALL_NUM_REASONS];
+
+  struct WarpPerf {
+    WarpPerf();
+    uint64_t issued, stalled, idle;           // cycles
+    uint64_t instructions, lanes, loads, stores, divergences;
+    uint64_t stalls[STALL_NUM_REASONS];       // stalled cycles by reason
+  };
+
+  struct PcPerf {
+    PcPerf() : count(0), lanes(0), divergences(0), stalls(0) {}
+    uint64_t count, lanes, divergences;
+    uint64_t stalls; // cycles the pipeline was blocked on this pc
+  };
+
+  /* Per-warp and per-PC counters of one core. */
+  class PerfCounters {
+  public:
+    PerfCounters(Word core, Size nWarps) :
+      core(core), cycles(0), warps(nWarps) {}
+
+    void retire(Word wid, Word pc, uint32_t lanes, bool load, bool store) {
+      WarpPerf &w = warps[wid];
+      PcPerf &p = pcs[pc];
+      unsigned n = __builtin_popcount(lanes);
+      ++w.instructions; w.lanes += n; w.loads += load; w.stores += store;
+      ++p.count; p.lanes += n;
+    }
+
+    void diverge(Word wid, Word pc) {
+      ++warps[wid].divergences;
+      ++pcs[pc].divergences;
+    }
+
+    void stall(Word wid, StallReason r) {
+      ++warps[wid].stalled;
+      ++warps[wid].stalls[r];
+    }
+
+    /* The core as one JSON object. */
+    void writeJson(std::ostream &os) const;
+
+    /* Flat profile, one "core pc count lanes divergences stalls" line per
+       pc, pc in objdump's bare hex so it joins against kernel.dump. */
+    void writeFlat(std::ostream &os) const;
+
+    /* Per-warp summary for printStats(). */
+    void printSummary(std::ostream &os) const;
+
+    Word core;
+    uint64_t cycles;
+    std::vector<WarpPerf> warps;
+    std::unordered_map<Word, PcPerf> pcs;
+  };
+
+  /* Write the cores' counters to <prefix>.json and their flat per-PC
+     profile to <prefix>.prof. */
+  bool writeProfile(const std::string &prefix,
+                    const std::vector<const PerfCounters *> &cores);
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include <stdint.h>
+#include <string>
+#include <iostream>
+
+#include "types.h"
+
+namespace Harp {
+  class CheckpointWriter;
+  class CheckpointReader;
+
+  /* Warp masks: bit w is warp w of a core. */
+  typedef uint32_t WarpMask;
+  static const Size MAX_WARPS = 32;
+
+  /* Warp scheduling policy of a core's fetch stage. pick() chooses the warp
+     to fetch from out of the ready mask, or returns -1 when none is ready;
+     policies keep whatever history they need between calls. */
+  class WarpScheduler {
+  public:
+    WarpScheduler(Size nWarps) :
+      issued(0), switches(0), noReady(0), blocked(0), nWarps(nWarps),
+      lastIssued(-1) {}
+    virtual ~WarpScheduler() {}
+
+    virtual const char *name() const = 0;
+    virtual int pick(WarpMask ready) = 0;
+
+    /* Fetch-stage accounting, one call per cycle from Core::fetch(). */
+    void issue(int wid) {
+      ++issued;
+      if (wid != lastIssued) ++switches;
+      lastIssued = wid;
+    }
+
+    /* "scheduler:" stats line; ipc is warp instructions per cycle. */
+    void printStats(std::ostream &os, uint64_t cycles) const;
+
+    /* Policy history and statistics, for checkpoints. */
+    virtual void save(CheckpointWriter &) const;
+    virtual void restore(CheckpointReader &);
+
+    uint64_t issued, switches;
+    uint64_t noReady; // cycles fetch was free but no warp was ready
+    uint64_t blocked; // cycles fetch was held by the pipeline or icache
+
+  protected:
+    Size nWarps;
+    int lastIssued;
+  };
+
+  /* Loose round robin: the first ready warp after the last pick. */
+  class LrrScheduler : public WarpScheduler {
+  public:
+    LrrScheduler(Size nWarps) : WarpScheduler(nWarps), last(0) {}
+    const char *name() const { return "lrr"; }
+    int pick(WarpMask ready);
+    void save(CheckpointWriter &) const;
+    void restore(CheckpointReader &);
+  private:
+    int last;
+  };
+
+  /* Greedy then oldest: keep the last warp while it stays ready, else the
+     oldest ready one. wspawn launches warps in id order, so the oldest is
+     the lowest id. */
+  class GtoScheduler : public WarpScheduler {
+  public:
+    GtoScheduler(Size nWarps) : WarpScheduler(nWarps), last(0) {}
+    const char *name() const { return "gto"; }
+    int pick(WarpMask ready);
+    void save(CheckpointWriter &) const;
+    void restore(CheckpointReader &);
+  private:
+    int last;
+  };
+
+  /* Two-level: warps form fetch groups of groupSize consecutive ids. Round
+     robin within the current group, which is only left once none of its
+     warps is ready. */
+  class TwoLevelScheduler : public WarpScheduler {
+  public:
+    TwoLevelScheduler(Size nWarps, Size groupSize);
+    const char *name() const { return "twolevel"; }
+    int pick(WarpMask ready);
+    void save(CheckpointWriter &) const;
+    void restore(CheckpointReader &);
+  private:
+    Size groupSize, nGroups, group;
+    int last;
+  };
+
+  /* "lrr", "gto" or "twolevel[:<group size>]" (default group size 4, at
+     most MAX_WARPS); NULL for anything else. */
+  WarpScheduler *makeScheduler(const std::string &policy, Size nWarps);
+}
+
+#endif
@@ -3,6 +3,10 @@
 
 namespace Harp {
 
+  /* Register ids in trace_inst_t, and so in the scoreboard: x0-x31 are
+     0-31 and f0-f31 follow. */
+  static const int TRACE_FREG = 32;
+
   typedef struct
   {
   	// Warp step
@@ -15,6 +19,7 @@ namespace Harp {
     // Encoder
     int        rs1;
     int        rs2;
+    int        rs3;
     int        rd;
 
     //Encoder
@@ -25,12 +30,15 @@ namespace Harp {
     // Instruction execute
     bool       is_lw;
     bool       is_sw;
-    unsigned * mem_addresses;
+    unsigned   mem_addresses[32];
 
     // dmem interface
     int        mem_stall_cycles;
     int        fetch_stall_cycles;
 
+    // Multi-cycle (FPU) ops: extra cycles in the execute unit
+    int        exe_stall_cycles;
+
     // Instruction execute
     bool stall_warp;
     bool wspawn;
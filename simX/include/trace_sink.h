@@ -0,0 +1,101 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __TRACE_SINK_H
+#define __TRACE_SINK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+namespace Harp {
+  /* Binary trace file: a TraceFileHeader followed by fixed-size TraceRecords
+     in host byte order. Each core buffers its own records, so the records of
+     different cores arrive in chunks; sort on (cycle, core) for a global
+     order. */
+  static const uint32_t TRACE_MAGIC   = 0x52545856; // "VXTR"
+  static const uint32_t TRACE_VERSION = 1;
+
+  enum TraceRecordType {
+    TRACE_STAGE  = 1, // a valid instruction in a pipeline stage, every cycle
+    TRACE_RETIRE = 2  // an instruction executed by a warp
+  };
+
+  enum TraceStage {
+    TRACE_FETCH, TRACE_DECODE, TRACE_SCHEDULE, TRACE_EXECUTE, TRACE_LSU,
+    TRACE_WRITEBACK, TRACE_NUM_STAGES
+  };
+
+  /* Record flags, mirroring trace_inst_t. */
+  enum TraceFlag {
+    TRACE_F_LOAD       = 1 << 0,
+    TRACE_F_STORE      = 1 << 1,
+    TRACE_F_STALL_WARP = 1 << 2,
+    TRACE_F_WSPAWN     = 1 << 3,
+    TRACE_F_STALLED    = 1 << 4
+  };
+
+  struct TraceFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+  };
+
+  struct TraceRecord {
+    uint64_t cycle;
+    uint32_t pc;
+    uint32_t tmask;       // retire: the lanes that executed
+    uint16_t core;
+    uint8_t  type;        // TraceRecordType
+    uint8_t  stage;       // TraceStage of a TRACE_STAGE record
+    uint8_t  wid;
+    int8_t   rd, rs1, rs2;
+    uint16_t fetch_stall;
+    uint16_t mem_stall;
+    uint32_t flags;       // TraceFlag bits
+  };
+
+  /* Trace file shared by the cores of a device. mask selects the record
+     types written, bit (1 << TraceRecordType). */
+  class TraceSink {
+  public:
+    TraceSink(const char *path, unsigned mask = ~0u);
+    ~TraceSink();
+
+    bool good() const { return file != NULL; }
+    bool wants(TraceRecordType t) const { return file && ((mask >> t) & 1); }
+
+    void write(const TraceRecord *records, size_t count);
+
+  private:
+    FILE *file;
+    unsigned mask;
+    std::mutex mutex;
+  };
+
+  /* A core's buffer in front of the shared sink. */
+  class TraceWriter {
+  public:
+    static const size_t CAPACITY = 4096;
+
+    TraceWriter(TraceSink &sink);
+    ~TraceWriter() { flush(); }
+
+    void push(const TraceRecord &r) {
+      buffer.push_back(r);
+      if (buffer.size() == CAPACITY) flush();
+    }
+
+    void flush();
+
+    const bool stages, retires;
+
+  private:
+    TraceSink &sink;
+    std::vector<TraceRecord> buffer;
+  };
+}
+
+#endif
@@ -0,0 +1,201 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#ifndef __VREG_H
+#define __VREG_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "types.h"
+
+namespace Harp {
+  /* RVV register file. The 32 registers are VLEN bits each and sit back to
+     back in one aligned buffer, so a register group (LMUL > 1) is simply the
+     following registers and element i of vN is vN's base pointer plus i. */
+  class VRegFile {
+  public:
+    static const Size NUM_REGS = 32;
+    static const Size MAX_LMUL = 8;
+    static const Size ALIGN    = 64;
+
+    VRegFile() : vlenb(0), data(NULL) {}
+
+    VRegFile(const VRegFile &rhs) : vlenb(0), data(NULL) { *this = rhs; }
+
+    VRegFile &operator=(const VRegFile &rhs) {
+      if (this != &rhs) {
+        resize(rhs.vlenb * 8);
+        if (vlenb) memcpy(data, rhs.data, bytes());
+      }
+      return *this;
+    }
+
+    ~VRegFile() { free(data); }
+
+    /* (Re)allocate for a VLEN of vlen bits; all registers read as zero. */
+    void resize(Size vlen) {
+      if (vlen / 8 != vlenb) {
+        free(data);
+        data = NULL;
+        vlenb = vlen / 8;
+        if (vlenb && posix_memalign((void **)&data, ALIGN, bytes()) != 0)
+          data = NULL;
+      }
+      clear();
+    }
+
+    void clear() { if (data) memset(data, 0, bytes()); }
+
+    /* Register r viewed as elements of type T (the current SEW). */
+    template <typename T> T *get(Size r) { return (T *)(data + r * vlenb); }
+
+    /* Bytes per register. */
+    Size regBytes() const { return vlenb; }
+
+    /* The whole backing store, for checkpoints. */
+    uint8_t *raw() const { return data; }
+    Size rawBytes() const { return data ? bytes() : 0; }
+
+  private:
+    /* A group based at v31 with LMUL=8 must not run off the end. */
+    Size bytes() const { return (NUM_REGS + MAX_LMUL - 1) * vlenb; }
+
+    Size vlenb;
+    uint8_t *data;
+  };
+
+  /* Element-wise kernels over contiguous registers, specialised on SEW by
+     the element type. The generic versions are plain loops the compiler can
+     vectorise; the 32-bit add/mul/macc kernels used by the vector
+     benchmarks have explicit host SIMD bodies. */
+  namespace VecOps {
+#if defined(__AVX2__)
+    typedef __m256i simd_t;
+    static const Size LANES = 8;
+    inline simd_t vld(const uint32_t *p) { return _mm256_loadu_si256((const simd_t *)p); }
+    inline void   vst(uint32_t *p, simd_t v) { _mm256_storeu_si256((simd_t *)p, v); }
+    inline simd_t vdup(uint32_t x) { return _mm256_set1_epi32(x); }
+    inline simd_t vadd(simd_t a, simd_t b) { return _mm256_add_epi32(a, b); }
+    inline simd_t vmul(simd_t a, simd_t b) { return _mm256_mullo_epi32(a, b); }
+#define HX_VEC_SIMD 1
+#elif defined(__SSE2__)
+    typedef __m128i simd_t;
+    static const Size LANES = 4;
+    inline simd_t vld(const uint32_t *p) { return _mm_loadu_si128((const simd_t *)p); }
+    inline void   vst(uint32_t *p, simd_t v) { _mm_storeu_si128((simd_t *)p, v); }
+    inline simd_t vdup(uint32_t x) { return _mm_set1_epi32(x); }
+    inline simd_t vadd(simd_t a, simd_t b) { return _mm_add_epi32(a, b); }
+    inline simd_t vmul(simd_t a, simd_t b) {
+#if defined(__SSE4_1__)
+      return _mm_mullo_epi32(a, b);
+#else
+      // even and odd lanes through the 32x32->64 multiplier
+      simd_t even = _mm_mul_epu32(a, b);
+      simd_t odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+      return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+    }
+#define HX_VEC_SIMD 1
+#elif defined(__ARM_NEON)
+    typedef uint32x4_t simd_t;
+    static const Size LANES = 4;
+    inline simd_t vld(const uint32_t *p) { return vld1q_u32(p); }
+    inline void   vst(uint32_t *p, simd_t v) { vst1q_u32(p, v); }
+    inline simd_t vdup(uint32_t x) { return vdupq_n_u32(x); }
+    inline simd_t vadd(simd_t a, simd_t b) { return vaddq_u32(a, b); }
+    inline simd_t vmul(simd_t a, simd_t b) { return vmulq_u32(a, b); }
+#define HX_VEC_SIMD 1
+#endif
+
+    /* vd[i] = f(vs1[i], vs2[i]) for i < vl. */
+    template <typename T, typename F>
+    inline void map(T *vd, const T *vs1, const T *vs2, Size vl, F f) {
+      for (Size i = 0; i < vl; ++i) vd[i] = f(vs1[i], vs2[i]);
+    }
+
+    /* As map(), skipping elements whose v0 mask bit is clear. */
+    template <typename T, typename F>
+    inline void mapMasked(T *vd, const T *vs1, const T *vs2, const T *mask,
+                          Size vl, F f)
+    {
+      for (Size i = 0; i < vl; ++i) if (mask[i] & 1) vd[i] = f(vs1[i], vs2[i]);
+    }
+
+    /* Zero the tail elements [vl, vlmax). */
+    template <typename T>
+    inline void zeroTail(T *vd, Size vl, Size vlmax) {
+      if (vl < vlmax) memset(vd + vl, 0, (vlmax - vl) * sizeof(T));
+    }
+
+    template <typename T>
+    inline void add(T *vd, const T *vs1, const T *vs2, Size vl) {
+      for (Size i = 0; i < vl; ++i) vd[i] = vs1[i] + vs2[i];
+    }
+
+    template <typename T>
+    inline void mul(T *vd, const T *vs1, const T *vs2, Size vl) {
+      for (Size i = 0; i < vl; ++i) vd[i] = T(Word(vs1[i]) * Word(vs2[i]));
+    }
+
+    template <typename T>
+    inline void macc(T *vd, const T *vs1, const T *vs2, Size vl) {
+      for (Size i = 0; i < vl; ++i) vd[i] += T(Word(vs1[i]) * Word(vs2[i]));
+    }
+
+    template <typename T>
+    inline void addScalar(T *vd, T x, const T *vs2, Size vl) {
+      for (Size i = 0; i < vl; ++i) vd[i] = x + vs2[i];
+    }
+
+    template <typename T>
+    inline void mulScalar(T *vd, T x, const T *vs2, Size vl) {
+      for (Size i = 0; i < vl; ++i) vd[i] = T(Word(x) * Word(vs2[i]));
+    }
+
+#ifdef HX_VEC_SIMD
+    inline void add(uint32_t *vd, const uint32_t *vs1, const uint32_t *vs2, Size vl) {
+      Size i = 0;
+      for (; i + LANES <= vl; i += LANES) vst(vd + i, vadd(vld(vs1 + i), vld(vs2 + i)));
+      for (; i < vl; ++i) vd[i] = vs1[i] + vs2[i];
+    }
+
+    inline void mul(uint32_t *vd, const uint32_t *vs1, const uint32_t *vs2, Size vl) {
+      Size i = 0;
+      for (; i + LANES <= vl; i += LANES) vst(vd + i, vmul(vld(vs1 + i), vld(vs2 + i)));
+      for (; i < vl; ++i) vd[i] = vs1[i] * vs2[i];
+    }
+
+    inline void macc(uint32_t *vd, const uint32_t *vs1, const uint32_t *vs2, Size vl) {
+      Size i = 0;
+      for (; i + LANES <= vl; i += LANES)
+        vst(vd + i, vadd(vld(vd + i), vmul(vld(vs1 + i), vld(vs2 + i))));
+      for (; i < vl; ++i) vd[i] += vs1[i] * vs2[i];
+    }
+
+    inline void addScalar(uint32_t *vd, uint32_t x, const uint32_t *vs2, Size vl) {
+      simd_t vx = vdup(x);
+      Size i = 0;
+      for (; i + LANES <= vl; i += LANES) vst(vd + i, vadd(vx, vld(vs2 + i)));
+      for (; i < vl; ++i) vd[i] = x + vs2[i];
+    }
+
+    inline void mulScalar(uint32_t *vd, uint32_t x, const uint32_t *vs2, Size vl) {
+      simd_t vx = vdup(x);
+      Size i = 0;
+      for (; i + LANES <= vl; i += LANES) vst(vd + i, vmul(vx, vld(vs2 + i)));
+      for (; i < vl; ++i) vd[i] = x * vs2[i];
+    }
+#endif
+  }
+}
+
+#endif
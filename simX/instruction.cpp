@@ -4,17 +4,22 @@
 #include <iostream>
 #include <stdlib.h>
 #include <math.h>
+#include <atomic>
 
 #include "include/instruction.h"
 #include "include/obj.h"
 #include "include/core.h"
 #include "include/harpfloat.h"
+#include "include/fpu.h"
 #include "include/debug.h"
 
+#include <VX_config.h>
+
 #ifdef EMU_INSTRUMENTATION
 #include "include/qsim-harp.h"
 #endif
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -50,31 +55,83 @@ ostream &Harp::operator<<(ostream &os, Instruction &inst) {
   return os;
 }
 
-bool checkUnanimous(unsigned p, const std::vector<std::vector<Reg<Word>>> &m,
-                    const std::vector<bool> &tm) {
-  bool same;
-  unsigned i;
-  for (i = 0; i < m.size(); ++i) {
-    if (tm[i]) {
-      same = m[i][p];
-      break;
-    }
-  }
-  if (i == m.size())
+/* Lanes of tm whose predicate register p is set. Throws if no lane is
+   active, since a split then has nothing to decide on. */
+ThreadMask predMask(const std::vector<Word> &p, ThreadMask tm) {
+  if (tm == 0)
     throw DivergentBranchException();
+  ThreadMask taken = 0;
+  for (ThreadMask m = tm; m; m &= m - 1) {
+    Size t = firstThread(m);
+    if (p[t]) taken |= ThreadMask(1) << t;
+  }
+  return taken;
+}
 
-  //std::cout << "same: " << same << "  with -> ";
-  for (; i < m.size(); ++i) {
-    if (tm[i]) {
-      //std::cout << " " << (bool(m[i][p]));
-      if (same != (bool(m[i][p]))) {
-        //std::cout << " FALSE\n";
-        return false;
-      }
+/* Lane loops. Each instruction is decoded and dispatched once per warp; its
+   semantics then run over the lanes set in en. With every lane enabled (the
+   common case) laneMap is a straight loop the compiler vectorises;
+   otherwise it visits the set bits only. */
+template <typename F>
+static inline void laneMap(Word *rd, ThreadMask en, Size n, F f) {
+  if (en == threadMaskLow(n)) {
+    for (Size t = 0; t < n; ++t) rd[t] = f(t);
+    return;
+  }
+  for (ThreadMask m = en; m; m &= m - 1) {
+    Size t = firstThread(m);
+    rd[t] = f(t);
+  }
+}
+
+/* True if f holds on any enabled lane. */
+template <typename F>
+static inline bool laneAny(ThreadMask en, F f) {
+  for (ThreadMask m = en; m; m &= m - 1) {
+    if (f(firstThread(m))) return true;
+  }
+  return false;
+}
+
+/* Load the word holding rs1 + imm on every enabled lane; extract picks the
+   result out of (word, byte shift). */
+template <typename F>
+static inline void laneLoad(Warp &c, Word *rd, const Word *rs1, Word imm,
+                            ThreadMask en, trace_inst_t *trace_inst, F extract)
+{
+  for (ThreadMask m = en; m; m &= m - 1) {
+    Size t = firstThread(m);
+    Word addr = rs1[t] + imm;
+    Word memAddr = addr & 0xFFFFFFFC;
+    Word data_read = c.core->mem.read(memAddr, c.supervisorMode);
+    trace_inst->mem_addresses[t] = memAddr;
+    rd[t] = extract(data_read, (addr & 0x00000003) * 8);
+    D(3, "LOAD MEM ADDRESS: " << std::hex << memAddr);
+    D(3, "LOAD MEM DATA: " << std::hex << data_read);
+  }
+}
+
+/* Store the low size bytes of rs2 to rs1 + imm on every enabled lane. */
+static inline void laneStore(Warp &c, const Word *rs1, const Word *rs2,
+                             Word imm, Size size, Word mask,
+                             ThreadMask en, trace_inst_t *trace_inst)
+{
+  for (ThreadMask m = en; m; m &= m - 1) {
+    Size t = firstThread(m);
+    ++c.stores;
+    Word memAddr = rs1[t] + imm;
+    trace_inst->mem_addresses[t] = memAddr;
+    if ((memAddr == 0x00010000) && (t == 0)) {
+      fprintf(stderr, "%c", (char)rs2[t]);
+      continue;
     }
+    c.core->mem.write(memAddr, rs2[t] & mask, c.supervisorMode, size);
+    D(3, "STORE MEM ADDRESS: " << std::hex << memAddr);
+    c.memAccesses.push_back(Warp::MemAccess(true, memAddr));
+#ifdef EMU_INSTRUMENTATION
+    Harp::OSDomain::osDomain->do_mem(0, memAddr, c.core->mem.virtToPhys(memAddr), 8, true);
+#endif
   }
-  //std::cout << " TRUE\n";
-  return true;
 }
 
 Word signExt(Word w, Size bit, Word mask) {
@@ -323,12 +380,8 @@ void Instruction::executeOn(Warp &c, trace_inst_t *trace_inst) {
     return;
   }
 
-  bool is_vec = false;
-
   Size nextActiveThreads = c.activeThreads;
-  Size wordSz = c.core->a.getWordSize();
   Word nextPc = c.pc;
-  Word VLMAX;
 
   c.memAccesses.clear();
 
@@ -337,1938 +390,553 @@ void Instruction::executeOn(Warp &c, trace_inst_t *trace_inst) {
     trap_to_simulator(c);
   }
 
-  bool sjOnce(true), // Has not yet split or joined once.
-      pcSet(false);  // PC has already been set
-  for (Size t = 0; t < c.activeThreads; t++) {
-    vector<Reg<Word>> &reg(c.reg[t]);
-    vector<Reg<bool>> &pReg(c.pred[t]);
-    stack<DomStackEntry> &domStack(c.domStack);
-
-    bool split = (op == GPGPU) && (func3 == 2);
-    bool join = (op == GPGPU) && (func3 == 3);
-
-    bool is_gpgpu = (op == GPGPU);
-
-    bool is_tmc = is_gpgpu && (func3 == 0);
-    bool is_wspawn = is_gpgpu && (func3 == 1);
-    bool is_barrier = is_gpgpu && (func3 == 4);
-    bool is_split = is_gpgpu && (func3 == 2);
-    bool is_join = is_gpgpu && (func3 == 3);
-
-    bool gpgpu_zero = (is_tmc || is_barrier || is_wspawn) && (t != 0);
-
-    bool not_active = !c.tmask[t];
-
-    if (not_active || gpgpu_zero) {
-      continue;
-    }
-
-    ++c.insts;
-
-    Word memAddr;
-    Word shift_by;
-    Word shamt;
-    Word temp;
-    Word data_read;
-    int op1, op2;
-    bool m_exten;
-    // std::cout << "op = " << op << "\n";
-    // std::cout << "R_INST: " << R_INST << "\n";
-    int num_to_wspawn;
-    switch (op) {
-
-    case NOP:
-      //std::cout << "NOP_INST\n";
-      break;
-    case R_INST:
-      // std::cout << "R_INST\n";
-      m_exten = func7 & 0x1;
-      if (m_exten) {
-        // std::cout << "FOUND A MUL/DIV\n";
-
-        switch (func3) {
-        case 0:
-          // MUL
-          D(3, "MUL: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          reg[rdest] = ((int)reg[rsrc[0]]) * ((int)reg[rsrc[1]]);
-          break;
-        case 1:
-          // MULH
-          D(3, "MULH: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          {
-            int64_t first = (int64_t)reg[rsrc[0]];
-            if (reg[rsrc[0]] & 0x80000000) {
-              first = first | 0xFFFFFFFF00000000;
-            }
-            int64_t second = (int64_t)reg[rsrc[1]];
-            if (reg[rsrc[1]] & 0x80000000) {
-              second = second | 0xFFFFFFFF00000000;
-            }
-            // cout << "mulh: " << std::dec << first << " * " << second;
-            uint64_t result = first * second;
-            reg[rdest] = (result >> 32) & 0xFFFFFFFF;
-            // cout << " = " << result << "   or  " <<  reg[rdest] << "\n";
-          }
-          break;
-        case 2:
-          // MULHSU
-          D(3, "MULHSU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          {
-            int64_t first = (int64_t)reg[rsrc[0]];
-            if (reg[rsrc[0]] & 0x80000000) {
-              first = first | 0xFFFFFFFF00000000;
-            }
-            int64_t second = (int64_t)reg[rsrc[1]];
-            reg[rdest] = ((first * second) >> 32) & 0xFFFFFFFF;
-          }
-          break;
-        case 3:
-          // MULHU
-          D(3, "MULHU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          {
-            uint64_t first = (uint64_t)reg[rsrc[0]];
-            uint64_t second = (uint64_t)reg[rsrc[1]];
-            // cout << "MULHU\n";
-            reg[rdest] = ((first * second) >> 32) & 0xFFFFFFFF;
-          }
-          break;
-        case 4:
-          // DIV
-          D(3, "DIV: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          if (reg[rsrc[1]] == 0) {
-            reg[rdest] = -1;
-            break;
-          }
-          // cout << "dividing: " << dec << ((int) reg[rsrc[0]]) << " / " << ((int) reg[rsrc[1]]);
-          reg[rdest] = ((int)reg[rsrc[0]]) / ((int)reg[rsrc[1]]);
-          // cout << " = " << ((int) reg[rdest]) << "\n";
-          break;
-        case 5:
-          // DIVU
-          D(3, "DIVU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          if (reg[rsrc[1]] == 0) {
-            reg[rdest] = -1;
-            break;
-          }
-          reg[rdest] = ((uint32_t)reg[rsrc[0]]) / ((uint32_t)reg[rsrc[1]]);
-          break;
-        case 6:
-          // REM
-          D(3, "REM: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          if (reg[rsrc[1]] == 0) {
-            reg[rdest] = reg[rsrc[0]];
-            break;
-          }
-          reg[rdest] = ((int)reg[rsrc[0]]) % ((int)reg[rsrc[1]]);
-          break;
-        case 7:
-          // REMU
-          D(3, "REMU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          if (reg[rsrc[1]] == 0) {
-            reg[rdest] = reg[rsrc[0]];
-            break;
-          }
-          reg[rdest] = ((uint32_t)reg[rsrc[0]]) % ((uint32_t)reg[rsrc[1]]);
-          break;
-        default:
-          cout << "unsupported MUL/DIV instr\n";
-          std::abort();
-        }
-      } else {
-        // std::cout << "NORMAL R-TYPE\n";
-        switch (func3) {
-        case 0:
-          if (func7) {
-            D(3, "SUBI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-            reg[rdest] = reg[rsrc[0]] - reg[rsrc[1]];
-            reg[rdest].trunc(wordSz);
-          } else {
-            D(3, "ADDI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-            reg[rdest] = reg[rsrc[0]] + reg[rsrc[1]];
-            reg[rdest].trunc(wordSz);
-          }
-          break;
-        case 1:
-          D(3, "SLLI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          reg[rdest] = reg[rsrc[0]] << reg[rsrc[1]];
-          reg[rdest].trunc(wordSz);
-          break;
-        case 2:
-          D(3, "SLTI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          if (int(reg[rsrc[0]]) < int(reg[rsrc[1]])) {
-            reg[rdest] = 1;
-          } else {
-            reg[rdest] = 0;
-          }
-          break;
-        case 3:
-          D(3, "SLTU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          if (Word_u(reg[rsrc[0]]) < Word_u(reg[rsrc[1]])) {
-            reg[rdest] = 1;
-          } else {
-            reg[rdest] = 0;
-          }
-          break;
-        case 4:
-          D(3, "XORI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          reg[rdest] = reg[rsrc[0]] ^ reg[rsrc[1]];
-          break;
-        case 5:
-          if (func7) {
-            D(3, "SRLI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-            reg[rdest] = int(reg[rsrc[0]]) >> int(reg[rsrc[1]]);
-            reg[rdest].trunc(wordSz);
-          } else {
-            D(3, "SRLU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-            reg[rdest] = Word_u(reg[rsrc[0]]) >> Word_u(reg[rsrc[1]]);
-            reg[rdest].trunc(wordSz);
-          }
-          break;
-        case 6:
-          D(3, "ORI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          reg[rdest] = reg[rsrc[0]] | reg[rsrc[1]];
-          break;
-        case 7:
-          D(3, "ANDI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
-          reg[rdest] = reg[rsrc[0]] & reg[rsrc[1]];
-          break;
-        default:
-          cout << "ERROR: UNSUPPORTED R INST\n";
-          std::abort();
-        }
-      }
-      break;
-    case L_INST:
-      memAddr = ((reg[rsrc[0]] + immsrc) & 0xFFFFFFFC);
-      shift_by = ((reg[rsrc[0]] + immsrc) & 0x00000003) * 8;
-      data_read = c.core->mem.read(memAddr, c.supervisorMode);
-      trace_inst->is_lw = true;
-      trace_inst->mem_addresses[t] = memAddr;
+  bool is_gpgpu = (op == GPGPU);
+  bool is_tmc = is_gpgpu && (func3 == 0);
+  bool is_wspawn = is_gpgpu && (func3 == 1);
+  bool is_barrier = is_gpgpu && (func3 == 4);
+
+  /* Enabled lanes: the active threads under the thread mask, or just thread
+     0 for the warp-wide tmc/wspawn/barrier. */
+  Size n = c.core->a.getNThds();
+  ThreadMask en = c.tmask & threadMaskLow(c.activeThreads);
+  if (is_tmc || is_barrier || is_wspawn) en &= 1;
+  if (en == 0) return;
+  Size nEn = threadCount(en), first = firstThread(en);
+
+  c.insts += nEn;
+
+  /* Register rows, [reg][lane]. */
+  Word *rd = rdestPresent ? &c.reg[rdest][0] : NULL;
+  const Word *rs1 = (nRsrc > 0) ? &c.reg[rsrc[0]][0] : NULL;
+  const Word *rs2 = (nRsrc > 1) ? &c.reg[rsrc[1]][0] : NULL;
+  Word imm = immsrc;
+
+  bool pcSet(false); // PC has already been set
+  Word csrId = immsrc & 0x00000FFF;
+  unsigned num_to_wspawn;
+  switch (op) {
+
+  case NOP:
+    break;
+  case R_INST:
+    if (func7 & 0x1) {
       switch (func3) {
       case 0:
-        // LBI
-        D(3, "LBI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        reg[rdest] = signExt((data_read >> shift_by) & 0xFF, 8, 0xFF);
+        // MUL
+        D(3, "MUL: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word { return rs1[t] * rs2[t]; });
         break;
       case 1:
-        // LWI
-        D(3, "LWI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        reg[rdest] = signExt((data_read >> shift_by) & 0xFFFF, 16, 0xFFFF);
+        // MULH
+        D(3, "MULH: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word {
+          return (int64_t(Word_s(rs1[t])) * int64_t(Word_s(rs2[t]))) >> 32;
+        });
         break;
       case 2:
-        // LDI
-        D(3, "LDI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        reg[rdest] = int(data_read & 0xFFFFFFFF);
-        break;
-      case 4:
-        // LBU
-        D(3, "LBU: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        reg[rdest] = unsigned((data_read >> shift_by) & 0xFF);
-        break;
-      case 5:
-        // LWU
-        D(3, "LWU: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        reg[rdest] = unsigned((data_read >> shift_by) & 0xFFFF);
-        break;
-      default:
-        cout << "ERROR: UNSUPPORTED L INST\n";
-        std::abort();
-        c.memAccesses.push_back(Warp::MemAccess(false, memAddr));
-      }
-      D(3, "LOAD MEM ADDRESS: " << std::hex << memAddr);
-      D(3, "LOAD MEM DATA: " << std::hex << data_read);
-      break;
-    case I_INST:
-      //std::cout << "I_INST\n";
-      switch (func3) {
-      case 0:
-        // ADDI
-        D(3, "ADDI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
-        reg[rdest] = reg[rsrc[0]] + immsrc;
-        reg[rdest].trunc(wordSz);
-        break;
-      case 2:
-        // SLTI
-        D(3, "SLTI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
-        if (int(reg[rsrc[0]]) < int(immsrc)) {
-          reg[rdest] = 1;
-        } else {
-          reg[rdest] = 0;
-        }
+        // MULHSU
+        D(3, "MULHSU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word {
+          return (int64_t(Word_s(rs1[t])) * int64_t(rs2[t])) >> 32;
+        });
         break;
       case 3:
-        // SLTIU
-        D(3, "SLTIU: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
-        op1 = (unsigned)reg[rsrc[0]];
-        if (unsigned(reg[rsrc[0]]) < unsigned(immsrc)) {
-          reg[rdest] = 1;
-        } else {
-          reg[rdest] = 0;
-        }
+        // MULHU
+        D(3, "MULHU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word {
+          return (uint64_t(rs1[t]) * uint64_t(rs2[t])) >> 32;
+        });
         break;
       case 4:
-        // XORI
-        D(3, "XORI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
-        reg[rdest] = reg[rsrc[0]] ^ immsrc;
+        // DIV
+        D(3, "DIV: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word {
+          Word_s a = rs1[t], b = rs2[t];
+          if (b == 0) return -1;
+          if (b == -1) return -Word(a); // INT_MIN / -1 overflows on the host
+          return a / b;
+        });
+        break;
+      case 5:
+        // DIVU
+        D(3, "DIVU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word {
+          return rs2[t] ? rs1[t] / rs2[t] : Word(-1);
+        });
         break;
       case 6:
-        // ORI
-        D(3, "ORI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
-        reg[rdest] = reg[rsrc[0]] | immsrc;
+        // REM
+        D(3, "REM: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word {
+          Word_s a = rs1[t], b = rs2[t];
+          if (b == 0) return a;
+          if (b == -1) return 0;
+          return a % b;
+        });
         break;
       case 7:
-        // ANDI
-        D(3, "ANDI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
-        reg[rdest] = reg[rsrc[0]] & immsrc;
-        break;
-      case 1:
-        // SLLI
-        D(3, "SLLI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
-        reg[rdest] = reg[rsrc[0]] << immsrc;
-        reg[rdest].trunc(wordSz);
-        break;
-      case 5:
-        if ((func7 == 0)) {
-          // SRLI
-          D(3, "SRLI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
-          bool isNeg = ((0x80000000 & reg[rsrc[0]])) > 0;
-          Word result = Word_u(reg[rsrc[0]]) >> Word_u(immsrc);
-          reg[rdest] = result;
-          reg[rdest].trunc(wordSz);
-        } else {
-          // SRAI
-          D(3, "SRAI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
-          op1 = reg[rsrc[0]];
-          op2 = immsrc;
-          reg[rdest] = op1 >> op2;
-          reg[rdest].trunc(wordSz);
-        }
+        // REMU
+        D(3, "REMU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word {
+          return rs2[t] ? rs1[t] % rs2[t] : rs1[t];
+        });
         break;
       default:
-        cout << "ERROR: UNSUPPORTED L INST\n";
+        cout << "unsupported MUL/DIV instr\n";
         std::abort();
       }
-      break;
-    case S_INST:
-      ++c.stores;
-      memAddr = reg[rsrc[0]] + immsrc;
-      trace_inst->is_sw = true;
-      trace_inst->mem_addresses[t] = memAddr;
-      // //std::cout << "FUNC3: " << func3 << "\n";
-      if ((memAddr == 0x00010000) && (t == 0)) {
-        unsigned num = reg[rsrc[1]];
-        fprintf(stderr, "%c", (char)reg[rsrc[1]]);
-        break;
-      }
+    } else {
       switch (func3) {
       case 0:
-        // SB
-        D(3, "SB: r" << rsrc[1] << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        c.core->mem.write(memAddr, reg[rsrc[1]] & 0x000000FF, c.supervisorMode, 1);
+        if (func7) {
+          D(3, "SUBI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+          laneMap(rd, en, n, [&](Size t) { return rs1[t] - rs2[t]; });
+        } else {
+          D(3, "ADDI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+          laneMap(rd, en, n, [&](Size t) { return rs1[t] + rs2[t]; });
+        }
         break;
       case 1:
-        // SH
-        D(3, "SH: r" << rsrc[1] << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        c.core->mem.write(memAddr, reg[rsrc[1]], c.supervisorMode, 2);
+        D(3, "SLLI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) { return rs1[t] << (rs2[t] & 0x1f); });
         break;
       case 2:
-        // SD
-        D(3, "SD: r" << rsrc[1] << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-        c.core->mem.write(memAddr, reg[rsrc[1]], c.supervisorMode, 4);
+        D(3, "SLTI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word { return Word_s(rs1[t]) < Word_s(rs2[t]); });
         break;
-      default:
-        cout << "ERROR: UNSUPPORTED S INST\n";
-        std::abort();
-      }
-      D(3, "STORE MEM ADDRESS: " << std::hex << memAddr);
-      c.memAccesses.push_back(Warp::MemAccess(true, memAddr));
-#ifdef EMU_INSTRUMENTATION
-      Harp::OSDomain::osDomain->do_mem(0, memAddr, c.core->mem.virtToPhys(memAddr), 8, true);
-#endif
-      break;
-    case B_INST:
-      trace_inst->stall_warp = true;
-      switch (func3) {
-      case 0:
-        // BEQ
-        D(3, "BEQ: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
-        if (int(reg[rsrc[0]]) == int(reg[rsrc[1]])) {
-          if (!pcSet)
-            nextPc = (c.pc - 4) + immsrc;
-          pcSet = true;
-        }
-        break;
-      case 1:
-        // BNE
-        D(3, "BNE: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
-        if (int(reg[rsrc[0]]) != int(reg[rsrc[1]])) {
-          if (!pcSet)
-            nextPc = (c.pc - 4) + immsrc;
-          pcSet = true;
-        }
+      case 3:
+        D(3, "SLTU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) -> Word { return rs1[t] < rs2[t]; });
         break;
       case 4:
-        // BLT
-        D(3, "BLT: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
-        if (int(reg[rsrc[0]]) < int(reg[rsrc[1]])) {
-          if (!pcSet)
-            nextPc = (c.pc - 4) + immsrc;
-          pcSet = true;
-        }
+        D(3, "XORI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) { return rs1[t] ^ rs2[t]; });
         break;
       case 5:
-        // BGE
-        D(3, "BGE: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
-        if (int(reg[rsrc[0]]) >= int(reg[rsrc[1]])) {
-          if (!pcSet)
-            nextPc = (c.pc - 4) + immsrc;
-          pcSet = true;
+        if (func7) {
+          D(3, "SRLI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+          laneMap(rd, en, n, [&](Size t) -> Word { return Word_s(rs1[t]) >> (rs2[t] & 0x1f); });
+        } else {
+          D(3, "SRLU: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+          laneMap(rd, en, n, [&](Size t) { return rs1[t] >> (rs2[t] & 0x1f); });
         }
         break;
       case 6:
-        // BLTU
-        D(3, "BLTU: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
-        if (Word_u(reg[rsrc[0]]) < Word_u(reg[rsrc[1]])) {
-          if (!pcSet)
-            nextPc = (c.pc - 4) + immsrc;
-          pcSet = true;
-        }
+        D(3, "ORI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) { return rs1[t] | rs2[t]; });
         break;
       case 7:
-        // BGEU
-        D(3, "BGEU: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
-        if (Word_u(reg[rsrc[0]]) >= Word_u(reg[rsrc[1]])) {
-          if (!pcSet)
-            nextPc = (c.pc - 4) + immsrc;
-          pcSet = true;
-        }
+        D(3, "ANDI: r" << rdest << " <- r" << rsrc[0] << ", r" << rsrc[1]);
+        laneMap(rd, en, n, [&](Size t) { return rs1[t] & rs2[t]; });
         break;
+      default:
+        cout << "ERROR: UNSUPPORTED R INST\n";
+        std::abort();
       }
+    }
+    break;
+  case L_INST:
+    trace_inst->is_lw = true;
+    switch (func3) {
+    case 0:
+      // LBI
+      D(3, "LBI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneLoad(c, rd, rs1, imm, en, trace_inst, [](Word d, Word s) {
+        return signExt((d >> s) & 0xFF, 8, 0xFF);
+      });
       break;
-    case LUI_INST:
-      D(3, "LUI: r" << rdest << " <- imm=0x" << hex << immsrc);
-      reg[rdest] = (immsrc << 12) & 0xfffff000;
+    case 1:
+      // LWI
+      D(3, "LWI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneLoad(c, rd, rs1, imm, en, trace_inst, [](Word d, Word s) {
+        return signExt((d >> s) & 0xFFFF, 16, 0xFFFF);
+      });
       break;
-    case AUIPC_INST:
-      D(3, "AUIPC: r" << rdest << " <- imm=0x" << hex << immsrc);
-      reg[rdest] = ((immsrc << 12) & 0xfffff000) + (c.pc - 4);
+    case 2:
+      // LDI
+      D(3, "LDI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneLoad(c, rd, rs1, imm, en, trace_inst, [](Word d, Word) { return d; });
       break;
-    case JAL_INST:
-      D(3, "JAL: r" << rdest << " <- imm=" << (int)immsrc);
-      trace_inst->stall_warp = true;
-      if (!pcSet)
-        nextPc = (c.pc - 4) + immsrc;
-      if (!pcSet) { /*std::cout << "JAL... SETTING PC: " << nextPc << "\n"; */
-      }
-      if (rdest != 0) {
-        reg[rdest] = c.pc;
-      }
-      pcSet = true;
+    case 4:
+      // LBU
+      D(3, "LBU: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneLoad(c, rd, rs1, imm, en, trace_inst, [](Word d, Word s) {
+        return (d >> s) & 0xFF;
+      });
       break;
-    case JALR_INST:
-      D(3, "JALR: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-      trace_inst->stall_warp = true;
-      if (!pcSet)
-        nextPc = reg[rsrc[0]] + immsrc;
-      if (!pcSet) { /*std::cout << "JALR... SETTING PC: " << nextPc << "\n";*/
-      }
-      if (rdest != 0) {
-        reg[rdest] = c.pc;
-      }
-      pcSet = true;
+    case 5:
+      // LWU
+      D(3, "LWU: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneLoad(c, rd, rs1, imm, en, trace_inst, [](Word d, Word s) {
+        return (d >> s) & 0xFFFF;
+      });
       break;
-    case SYS_INST:      
-      D(3, "SYS_INST: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
-      temp = reg[rsrc[0]];      
-      // GPGPU CSR extension        
-      if (immsrc == 0x20) { 
-        // ThreadID
-        reg[rdest] = t;
-        D(3, "vx_threadID: r" << rdest << "=" << reg[rdest]);
-      } else if (immsrc == 0x21) { 
-        // WarpID
-        reg[rdest] = c.id;
-        D(3, "vx_warpID: r" << rdest << "=" << reg[rdest]);
-      } else if (immsrc == 0x22) { 
-        // WarpNum          
-        reg[rdest] = c.id;
-        D(3, "vx_warpNum: r" << rdest << "=" << reg[rdest]);
-      } else if (immsrc == 0x25) {
-        // NumInsts
-        reg[rdest] = c.core->num_instructions;
-        D(3, "vx_getInst: r" << rdest << "=" << reg[rdest]);
-      } else if (immsrc == 0x26) {          
-        // NumCycles
-        reg[rdest] = c.core->num_cycles;
-        D(3, "vx_getCycle: r" << rdest << "=" << reg[rdest]);
-      } else {        
-        switch (func3) {
-        case 0:
-          if (immsrc < 2) {
-            //std::cout << "INTERRUPT ECALL/EBREAK\n";
-            nextActiveThreads = 0;
-            c.spawned = false;
-            // c.interrupt(0);
-          }
-          break;
-        case 1:
-          // printf("Case 1\n");
-          if (rdest != 0) {
-            reg[rdest] = c.csr[immsrc & 0x00000FFF];
-          }
-          c.csr[immsrc & 0x00000FFF] = temp;
-          break;
-        case 2:
-          // printf("Case 2\n");
-          if (rdest != 0) {
-            // printf("Reading from CSR: %d = %d\n", (immsrc & 0x00000FFF),  c.csr[immsrc & 0x00000FFF]);
-            reg[rdest] = c.csr[immsrc & 0x00000FFF];
-          }
-          // printf("Writing to CSR --> %d = %d\n", immsrc,  (temp |  c.csr[immsrc & 0x00000FFF]));
-          c.csr[immsrc & 0x00000FFF] = temp | c.csr[immsrc & 0x00000FFF];
-          break;
-        case 3:
-          // printf("Case 3\n");
-          if (rdest != 0) {
-            reg[rdest] = c.csr[immsrc & 0x00000FFF];
-          }
-          c.csr[immsrc & 0x00000FFF] = temp & (~c.csr[immsrc & 0x00000FFF]);
-          break;
-        case 5:
-          // printf("Case 5\n");
-          if (rdest != 0) {
-            reg[rdest] = c.csr[immsrc & 0x00000FFF];
-          }
-          c.csr[immsrc & 0x00000FFF] = rsrc[0];
-          break;
-        case 6:
-          // printf("Case 6\n");
-          if (rdest != 0) {
-            reg[rdest] = c.csr[immsrc & 0x00000FFF];
-          }
-          c.csr[immsrc & 0x00000FFF] = rsrc[0] | c.csr[immsrc & 0x00000FFF];
-          break;
-        case 7:
-          // printf("Case 7\n");
-          if (rdest != 0) {
-            reg[rdest] = c.csr[immsrc & 0x00000FFF];
-          }
-          c.csr[immsrc & 0x00000FFF] = rsrc[0] & (~c.csr[immsrc & 0x00000FFF]);
-          break;
-        default:
-          break;
-        }
-      }
+    default:
+      cout << "ERROR: UNSUPPORTED L INST\n";
+      std::abort();
+    }
+    break;
+  case I_INST:
+    switch (func3) {
+    case 0:
+      // ADDI
+      D(3, "ADDI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
+      laneMap(rd, en, n, [&](Size t) { return rs1[t] + imm; });
       break;
-    case TRAP:
-      D(3, "TRAP");
-      nextActiveThreads = 0;
-      c.interrupt(0);
+    case 2:
+      // SLTI
+      D(3, "SLTI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
+      laneMap(rd, en, n, [&](Size t) -> Word { return Word_s(rs1[t]) < Word_s(imm); });
       break;
-    case FENCE:
-      D(3, "FENCE");
+    case 3:
+      // SLTIU
+      D(3, "SLTIU: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
+      laneMap(rd, en, n, [&](Size t) -> Word { return rs1[t] < imm; });
       break;
-    case PJ_INST:
-      D(3, "PJ_INST: r" << rsrc[0] << ", r" << rsrc[1]);
-      if (reg[rsrc[0]]) {
-        if (!pcSet)
-          nextPc = reg[rsrc[1]];
-        pcSet = true;
+    case 4:
+      // XORI
+      D(3, "XORI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
+      laneMap(rd, en, n, [&](Size t) { return rs1[t] ^ imm; });
+      break;
+    case 6:
+      // ORI
+      D(3, "ORI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
+      laneMap(rd, en, n, [&](Size t) { return rs1[t] | imm; });
+      break;
+    case 7:
+      // ANDI
+      D(3, "ANDI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
+      laneMap(rd, en, n, [&](Size t) { return rs1[t] & imm; });
+      break;
+    case 1:
+      // SLLI
+      D(3, "SLLI: r" << rdest << " <- r" << rsrc[0] << ", imm=0x" << hex << immsrc);
+      laneMap(rd, en, n, [&](Size t) { return rs1[t] << (imm & 0x1f); });
+      break;
+    case 5:
+      if ((func7 == 0)) {
+        // SRLI
+        D(3, "SRLI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
+        laneMap(rd, en, n, [&](Size t) { return rs1[t] >> (imm & 0x1f); });
+      } else {
+        // SRAI
+        D(3, "SRAI: r" << rdest << " <- r" << rsrc[0] << ", imm=" << immsrc);
+        laneMap(rd, en, n, [&](Size t) -> Word { return Word_s(rs1[t]) >> (imm & 0x1f); });
       }
       break;
-    case GPGPU:
-      switch (func3) {
-      case 1:
-        // WSPAWN
-        D(3, "WSPAWN: r" << rsrc[0] << ", r" << rsrc[1]);
-        trace_inst->wspawn = true;
-        if (sjOnce) {
-          sjOnce = false;
-          num_to_wspawn = std::min<unsigned>(reg[rsrc[0]], c.core->a.getNWarps());
-          D(0, "Spawning " << num_to_wspawn << " new warps at PC: " << hex << reg[rsrc[1]]);
-          for (unsigned i = 1; i < num_to_wspawn; ++i) {
-            Warp &newWarp(c.core->w[i]);
-            {
-              newWarp.pc = reg[rsrc[1]];
-              for (int kk = 0; kk < newWarp.tmask.size(); kk++) {
-                if (kk == 0) {
-                  newWarp.tmask[kk] = true;
-                } else {
-                  newWarp.tmask[kk] = false;
-                }
-              }
-              newWarp.activeThreads = 1;
-              newWarp.supervisorMode = false;
-              newWarp.spawned = true;
-            }
-          }
-          break;
-        }
+    default:
+      cout << "ERROR: UNSUPPORTED L INST\n";
+      std::abort();
+    }
+    break;
+  case S_INST:
+    trace_inst->is_sw = true;
+    switch (func3) {
+    case 0:
+      // SB
+      D(3, "SB: r" << rsrc[1] << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneStore(c, rs1, rs2, imm, 1, 0x000000FF, en, trace_inst);
+      break;
+    case 1:
+      // SH
+      D(3, "SH: r" << rsrc[1] << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneStore(c, rs1, rs2, imm, 2, 0xFFFFFFFF, en, trace_inst);
+      break;
+    case 2:
+      // SD
+      D(3, "SD: r" << rsrc[1] << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+      laneStore(c, rs1, rs2, imm, 4, 0xFFFFFFFF, en, trace_inst);
+      break;
+    default:
+      cout << "ERROR: UNSUPPORTED S INST\n";
+      std::abort();
+    }
+    break;
+  case B_INST: {
+    trace_inst->stall_warp = true;
+    bool taken = false;
+    switch (func3) {
+    case 0:
+      // BEQ
+      D(3, "BEQ: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
+      taken = laneAny(en, [&](Size t) { return rs1[t] == rs2[t]; });
+      break;
+    case 1:
+      // BNE
+      D(3, "BNE: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
+      taken = laneAny(en, [&](Size t) { return rs1[t] != rs2[t]; });
+      break;
+    case 4:
+      // BLT
+      D(3, "BLT: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
+      taken = laneAny(en, [&](Size t) { return Word_s(rs1[t]) < Word_s(rs2[t]); });
+      break;
+    case 5:
+      // BGE
+      D(3, "BGE: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
+      taken = laneAny(en, [&](Size t) { return Word_s(rs1[t]) >= Word_s(rs2[t]); });
+      break;
+    case 6:
+      // BLTU
+      D(3, "BLTU: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
+      taken = laneAny(en, [&](Size t) { return rs1[t] < rs2[t]; });
+      break;
+    case 7:
+      // BGEU
+      D(3, "BGEU: r" << rsrc[0] << ", r" << rsrc[1] << ", imm=" << (int)immsrc);
+      taken = laneAny(en, [&](Size t) { return rs1[t] >= rs2[t]; });
+      break;
+    }
+    if (taken) {
+      nextPc = (c.pc - 4) + immsrc;
+      pcSet = true;
+    }
+  } break;
+  case LUI_INST:
+    D(3, "LUI: r" << rdest << " <- imm=0x" << hex << immsrc);
+    imm = (immsrc << 12) & 0xfffff000;
+    laneMap(rd, en, n, [&](Size) { return imm; });
+    break;
+  case AUIPC_INST:
+    D(3, "AUIPC: r" << rdest << " <- imm=0x" << hex << immsrc);
+    imm = ((immsrc << 12) & 0xfffff000) + (c.pc - 4);
+    laneMap(rd, en, n, [&](Size) { return imm; });
+    break;
+  case JAL_INST:
+    D(3, "JAL: r" << rdest << " <- imm=" << (int)immsrc);
+    trace_inst->stall_warp = true;
+    nextPc = (c.pc - 4) + immsrc;
+    imm = c.pc;
+    laneMap(rd, en, n, [&](Size) { return imm; });
+    pcSet = true;
+    break;
+  case JALR_INST:
+    D(3, "JALR: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+    trace_inst->stall_warp = true;
+    nextPc = rs1[first] + immsrc;
+    imm = c.pc;
+    laneMap(rd, en, n, [&](Size) { return imm; });
+    pcSet = true;
+    break;
+  case SYS_INST:
+    D(3, "SYS_INST: r" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+    // GPGPU CSR extension
+    if (immsrc == 0x20 || immsrc == 0x22) {
+      // LTID, GTID: per lane
+      Word base = (immsrc == 0x22)
+                ? (c.core->id * c.core->a.getNWarps() + c.id) * n : 0;
+      laneMap(rd, en, n, [&](Size t) { return base + Word(t); });
+      D(3, "vx_csr 0x" << hex << immsrc << ": r" << dec << rdest);
+    } else if (immsrc >= 0x21 && immsrc <= 0x27) {
+      // Numbering per VX_config.vh, as read by the runtime
+      switch (immsrc) {
+      case 0x21: // LWID
+        imm = c.id;
         break;
-      case 2: {
-        // SPLIT
-        D(3, "SPLIT: r" << pred);
-        trace_inst->stall_warp = true;
-        if (sjOnce) {
-          sjOnce = false;
-          if (checkUnanimous(pred, c.reg, c.tmask)) {
-            D(3, "Unanimous pred: " << pred << "  val: " << reg[pred] << "\n");
-            DomStackEntry e(c.tmask);
-            e.uni = true;
-            c.domStack.push(e);
-            break;
-          }
-          D(3, "Split: Original TM: ");
-          for (auto y : c.tmask)
-            D(3, y << " ");
-
-          DomStackEntry e(pred, c.reg, c.tmask, c.pc);
-          c.domStack.push(c.tmask);
-          c.domStack.push(e);
-          for (unsigned i = 0; i < e.tmask.size(); ++i) {
-            c.tmask[i] = !e.tmask[i] && c.tmask[i];
-          }
-
-          D(3, "Split: New TM");
-          for (auto y : c.tmask)
-            D(3, y << " ");
-          D(3, "Split: Pushed TM PC: " << hex << e.pc << dec << "\n");
-          for (auto y : e.tmask)
-            D(3, y << " ");
-        }
+      case 0x23: // GWID
+        imm = c.core->id * c.core->a.getNWarps() + c.id;
         break;
-      }
-      case 3:
-        // JOIN
-         D(3, "JOIN");
-        if (sjOnce) {
-          sjOnce = false;
-          if (!c.domStack.empty() && c.domStack.top().uni) {
-            D(2, "Uni branch at join");
-            printf("NEW DOMESTACK: \n");
-            c.tmask = c.domStack.top().tmask;
-            c.domStack.pop();
-            break;
-          }
-          if (!c.domStack.top().fallThrough) {
-            if (!pcSet) {
-              nextPc = c.domStack.top().pc;
-              D(3, "join: NOT FALLTHROUGH PC: " << hex << nextPc << dec);
-            }
-            pcSet = true;
-          }
-
-          D(3, "Join: Old TM: ");
-          for (auto y : c.tmask)
-            D(3, y << " ");
-          cout << "\n";
-          c.tmask = c.domStack.top().tmask;
-
-          D(3, "Join: New TM: ");
-          for (auto y : c.tmask)
-            D(3, y << " ");
-
-          c.domStack.pop();
-        }
+      case 0x24: // GCID
+        imm = c.core->id;
         break;
-      case 4:
-        trace_inst->stall_warp = true;
-        // is_barrier
+      case 0x25: // NT
+        imm = n;
         break;
-      case 0:
-        // TMC
-        D(3, "TMC: r" << rsrc[0]);
-        trace_inst->stall_warp = true;
-        nextActiveThreads = std::min<unsigned>(reg[rsrc[0]], c.core->a.getNThds());
-        {
-          for (int ff = 0; ff < c.tmask.size(); ff++) {
-            if (ff < nextActiveThreads) {
-              c.tmask[ff] = true;
-            } else {
-              c.tmask[ff] = false;
-            }
-          }
-        }
-        if (nextActiveThreads == 0) {
-          c.spawned = false;
-        }
+      case 0x26: // NW
+        imm = c.core->a.getNWarps();
+        break;
+      case 0x27: // NC
+        imm = c.core->num_cores;
         break;
-      default:
-        cout << "ERROR: UNSUPPORTED GPGPU INSTRUCTION " << *this << "\n";
       }
-      break;
-    case VSET_ARITH:
-      D(3, "VSET_ARITH");
-      is_vec = true;
-      switch (func3) {
-      case 0: // vector-vector
-        trace_inst->vs1 = rsrc[0];
-        trace_inst->vs2 = rsrc[1];
-        trace_inst->vd = rdest;
-        switch (func6) {
-        case 0: {
-          is_vec = true;
-          D(3, "Addition " << rsrc[0] << " " << rsrc[1] << " Dest:" << rdest);
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          vector<Reg<char *>> &mask = c.vreg[0];
-
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *mask_ptr = (uint8_t *)mask[i].val;
-              uint8_t value = (*mask_ptr & 0x1);
-              if (vmask || (!vmask && value)) {
-                uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-                uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-                uint8_t result = *first_ptr + *second_ptr;
-                D(3, "Adding " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-                uint8_t *result_ptr = (uint8_t *)vd[i].val;
-                *result_ptr = result;
-              }
-            }
-
-          } else if (c.vtype.vsew == 16) {
-
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *mask_ptr = (uint16_t *)mask[i].val;
-              uint16_t value = (*mask_ptr & 0x1);
-              if (vmask || (!vmask && value)) {
-                uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-                uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-                uint16_t result = *first_ptr + *second_ptr;
-                D(3, "Adding " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-                uint16_t *result_ptr = (uint16_t *)vd[i].val;
-                *result_ptr = result;
-              }
-            }
-          } else if (c.vtype.vsew == 32) {
-            D(3, "Doing 32 bit vector addition");
-            for (Word i = 0; i < c.vl; i++) {
-              int *mask_ptr = (int *)mask[i].val;
-              int value = (*mask_ptr & 0x1);
-              if (vmask || (!vmask && value)) {
-                int *first_ptr = (int *)vr1[i].val;
-                int *second_ptr = (int *)vr2[i].val;
-                int result = *first_ptr + *second_ptr;
-                D(3, "Adding " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-                int *result_ptr = (int *)vd[i].val;
-                *result_ptr = result;
-              }
-            }
-          }
-
-          D(3, "Vector Register state after addition:" << flush);
-          for (int i = 0; i < c.vreg.size(); i++) {
-            for (int j = 0; j < c.vreg[0].size(); j++) {
-              if (c.vtype.vsew == 8) {
-                uint8_t *ptr_val = (uint8_t *)c.vreg[i][j].val;
-                D(3, "reg[" << i << "][" << j << "] = " << *ptr_val);
-              } else if (c.vtype.vsew == 16) {
-                uint16_t *ptr_val = (uint16_t *)c.vreg[i][j].val;
-                D(3, "reg[" << i << "][" << j << "] = " << *ptr_val);
-              } else if (c.vtype.vsew == 32) {
-                uint32_t *ptr_val = (uint32_t *)c.vreg[i][j].val;
-                D(3, "reg[" << i << "][" << j << "] = " << *ptr_val);
-              }
-            }
-          }
-
-          D(3, "After vector register state after addition" << flush);
-        } break;
-        case 24: //vmseq
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (*first_ptr == *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (*first_ptr == *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (*first_ptr == *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-
-        } break;
-        case 25: //vmsne
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (*first_ptr != *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (*first_ptr != *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (*first_ptr != *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-
-        } break;
-        case 26: //vmsltu
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (*first_ptr < *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (*first_ptr < *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (*first_ptr < *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-
-        } break;
-        case 27: //vmslt
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (int8_t i = 0; i < c.vl; i++) {
-              int8_t *first_ptr = (int8_t *)vr1[i].val;
-              int8_t *second_ptr = (int8_t *)vr2[i].val;
-              int8_t result = (*first_ptr < *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int8_t *result_ptr = (int8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (int16_t i = 0; i < c.vl; i++) {
-              int16_t *first_ptr = (int16_t *)vr1[i].val;
-              int16_t *second_ptr = (int16_t *)vr2[i].val;
-              int16_t result = (*first_ptr < *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int16_t *result_ptr = (int16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (int32_t i = 0; i < c.vl; i++) {
-              int32_t *first_ptr = (int32_t *)vr1[i].val;
-              int32_t *second_ptr = (int32_t *)vr2[i].val;
-              int32_t result = (*first_ptr < *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int32_t *result_ptr = (int32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-        } break;
-        case 28: //vmsleu
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (*first_ptr <= *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (*first_ptr <= *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (*first_ptr <= *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-        } break;
-        case 29: //vmsle
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (int8_t i = 0; i < c.vl; i++) {
-              int8_t *first_ptr = (int8_t *)vr1[i].val;
-              int8_t *second_ptr = (int8_t *)vr2[i].val;
-              int8_t result = (*first_ptr <= *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int8_t *result_ptr = (int8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (int16_t i = 0; i < c.vl; i++) {
-              int16_t *first_ptr = (int16_t *)vr1[i].val;
-              int16_t *second_ptr = (int16_t *)vr2[i].val;
-              int16_t result = (*first_ptr <= *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int16_t *result_ptr = (int16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (int32_t i = 0; i < c.vl; i++) {
-              int32_t *first_ptr = (int32_t *)vr1[i].val;
-              int32_t *second_ptr = (int32_t *)vr2[i].val;
-              int32_t result = (*first_ptr <= *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int32_t *result_ptr = (int32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-        } break;
-        case 30: //vmsgtu
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (*first_ptr > *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (*first_ptr > *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (*first_ptr > *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-        } break;
-        case 31: //vmsgt
-        {
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (int8_t i = 0; i < c.vl; i++) {
-              int8_t *first_ptr = (int8_t *)vr1[i].val;
-              int8_t *second_ptr = (int8_t *)vr2[i].val;
-              int8_t result = (*first_ptr > *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int8_t *result_ptr = (int8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (int16_t i = 0; i < c.vl; i++) {
-              int16_t *first_ptr = (int16_t *)vr1[i].val;
-              int16_t *second_ptr = (int16_t *)vr2[i].val;
-              int16_t result = (*first_ptr > *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int16_t *result_ptr = (int16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (int32_t i = 0; i < c.vl; i++) {
-              int32_t *first_ptr = (int32_t *)vr1[i].val;
-              int32_t *second_ptr = (int32_t *)vr2[i].val;
-              int32_t result = (*first_ptr > *second_ptr) ? 1 : 0;
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              int32_t *result_ptr = (int32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-          }
-        } break;
+      laneMap(rd, en, n, [&](Size) { return imm; });
+      D(3, "vx_csr 0x" << hex << immsrc << ": r" << dec << rdest << "=" << imm);
+    } else if (func3 == 0) {
+      if (immsrc < 2) {
+        // ECALL/EBREAK
+        nextActiveThreads = 0;
+        c.spawned = false;
+      }
+    } else if (func3 != 4) {
+      // Zicsr: the lanes read-modify-write the CSR one after the other
+      for (ThreadMask m = en; m; m &= m - 1) {
+        Size t = firstThread(m);
+        Word old = c.getCsr(csrId);
+        Word src = (func3 < 4) ? rs1[t] : rsrc[0];
+        if (rdest != 0) rd[t] = old;
+        switch (func3 & 3) {
+        case 1: c.setCsr(csrId, src); break;
+        case 2: if (src) c.setCsr(csrId, old | src); break;
+        case 3: if (src) c.setCsr(csrId, old & ~src); break;
         }
+      }
+    }
+    break;
+  case TRAP:
+    D(3, "TRAP");
+    nextActiveThreads = 0;
+    c.interrupt(0);
+    break;
+  case FENCE:
+    D(3, "FENCE");
+    // Order this core's accesses against the other core threads
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (func3 == 1) {
+      // FENCE.I
+      c.core->decodeCache.invalidateAll();
+    }
+    break;
+  case PJ_INST:
+    D(3, "PJ_INST: r" << rsrc[0] << ", r" << rsrc[1]);
+    for (ThreadMask m = en; m; m &= m - 1) {
+      Size t = firstThread(m);
+      if (rs1[t]) {
+        nextPc = rs2[t];
+        pcSet = true;
         break;
-      case 2: {
-        trace_inst->vs1 = rsrc[0];
-        trace_inst->vs2 = rsrc[1];
-        trace_inst->vd = rdest;
-        Word VLMAX = (c.vtype.vlmul * c.VLEN) / c.vtype.vsew;
-
-        switch (func6) {
-        case 24: //vmandnot
-        {
-          D(3, "vmandnot");
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = (first_value & !second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = (first_value & !second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = (first_value & !second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 25: //vmand
-        {
-          D(3, "vmand");
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = (first_value & second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = (first_value & second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = (first_value & second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-            for (Word i = c.vl; i < VLMAX; i++) {
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 26: //vmor
-        {
-          D(3, "vmor");
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = (first_value | second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            uint16_t *result_ptr;
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = (first_value | second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 32) {
-            uint32_t *result_ptr;
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = (first_value | second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            D(3, "VLMAX: " << VLMAX);
-            for (Word i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 27: //vmxor
-        {
-          D(3, "vmxor");
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            uint8_t *result_ptr;
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = (first_value ^ second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            uint16_t *result_ptr;
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = (first_value ^ second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            uint32_t *result_ptr;
-
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = (first_value ^ second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 28: //vmornot
-        {
-          D(3, "vmornot");
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = (first_value | !second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = (first_value | !second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = (first_value | !second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 29: //vmnand
-        {
-          D(3, "vmnand");
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = !(first_value & second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              uint8_t *result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = !(first_value & second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = !(first_value & second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-
-            for (Word i = c.vl; i < VLMAX; i++) {
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 30: //vmnor
-        {
-          D(3, "vmnor");
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            uint8_t *result_ptr;
-
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = !(first_value | second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = !(first_value | second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              uint16_t *result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = !(first_value | second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              uint32_t *result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 31: //vmxnor
-        {
-          D(3, "vmxnor");
-          uint8_t *result_ptr;
-
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t first_value = (*first_ptr & 0x1);
-              uint8_t second_value = (*second_ptr & 0x1);
-              uint8_t result = !(first_value ^ second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            uint16_t *result_ptr;
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t first_value = (*first_ptr & 0x1);
-              uint16_t second_value = (*second_ptr & 0x1);
-              uint16_t result = !(first_value ^ second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            uint32_t *result_ptr;
-
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t first_value = (*first_ptr & 0x1);
-              uint32_t second_value = (*second_ptr & 0x1);
-              uint32_t result = !(first_value ^ second_value);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 37: //vmul
-        {
-          D(3, "vmul");
-          uint8_t *result_ptr;
-
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (*first_ptr * *second_ptr);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            uint16_t *result_ptr;
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (*first_ptr * *second_ptr);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            uint32_t *result_ptr;
-
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (*first_ptr * *second_ptr);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 45: //vmacc
-        {
-          D(3, "vmacc");
-          uint8_t *result_ptr;
-
-          vector<Reg<char *>> &vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (*first_ptr * *second_ptr);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr += result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            uint16_t *result_ptr;
-            for (uint16_t i = 0; i < c.vl; i++) {
-              uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (*first_ptr * *second_ptr);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr += result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            uint32_t *result_ptr;
-
-            for (uint32_t i = 0; i < c.vl; i++) {
-              uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (*first_ptr * *second_ptr);
-              D(3, "Comparing " << *first_ptr << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr += result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        }
-      } break;
-      case 6: {
-        switch (func6) {
-        case 0: {
-          D(3, "vmadd.vx");
-          uint8_t *result_ptr;
-
-          //vector<Reg<char *>> & vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              //uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (reg[rsrc[0]] + *second_ptr);
-              D(3, "Comparing " << reg[rsrc[0]] << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            uint16_t *result_ptr;
-            for (uint16_t i = 0; i < c.vl; i++) {
-              //uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (reg[rsrc[0]] + *second_ptr);
-              D(3, "Comparing " << reg[rsrc[0]] << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            uint32_t *result_ptr;
-
-            for (uint32_t i = 0; i < c.vl; i++) {
-              //uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (reg[rsrc[0]] + *second_ptr);
-              D(3, "Comparing " << reg[rsrc[0]] << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        case 37: //vmul.vx
-        {
-          D(3, "vmul.vx");
-          uint8_t *result_ptr;
-
-          //vector<Reg<char *>> & vr1 = c.vreg[rsrc[0]];
-          vector<Reg<char *>> &vr2 = c.vreg[rsrc[1]];
-          vector<Reg<char *>> &vd = c.vreg[rdest];
-          if (c.vtype.vsew == 8) {
-            for (uint8_t i = 0; i < c.vl; i++) {
-              //uint8_t *first_ptr = (uint8_t *)vr1[i].val;
-              uint8_t *second_ptr = (uint8_t *)vr2[i].val;
-              uint8_t result = (reg[rsrc[0]] * *second_ptr);
-              D(3, "Comparing " << reg[rsrc[0]] << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint8_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint8_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          } else if (c.vtype.vsew == 16) {
-            uint16_t *result_ptr;
-            for (uint16_t i = 0; i < c.vl; i++) {
-              //uint16_t *first_ptr = (uint16_t *)vr1[i].val;
-              uint16_t *second_ptr = (uint16_t *)vr2[i].val;
-              uint16_t result = (reg[rsrc[0]] * *second_ptr);
-              D(3, "Comparing " << reg[rsrc[0]] << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (uint16_t i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint16_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-
-          } else if (c.vtype.vsew == 32) {
-            uint32_t *result_ptr;
-
-            for (uint32_t i = 0; i < c.vl; i++) {
-              //uint32_t *first_ptr = (uint32_t *)vr1[i].val;
-              uint32_t *second_ptr = (uint32_t *)vr2[i].val;
-              uint32_t result = (reg[rsrc[0]] * *second_ptr);
-              D(3, "Comparing " << reg[rsrc[0]] << " + " << *second_ptr << " = " << result);
-
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = result;
-            }
-            for (Word i = c.vl; i < VLMAX; i++) {
-              result_ptr = (uint32_t *)vd[i].val;
-              *result_ptr = 0;
-            }
-          }
-        } break;
-        }
-      } break;
-      case 7: {
-        is_vec = true;
-        c.vtype.vill = 0; //TODO
-        c.vtype.vediv = vediv;
-        c.vtype.vsew = vsew;
-        c.vtype.vlmul = vlmul;
-
-        Word VLMAX = (vlmul * c.VLEN) / vsew;
-        D(3, "lmul:" << vlmul << " sew:" << vsew << " ediv: " << vediv << "rsrc" << reg[rsrc[0]] << "VLMAX" << VLMAX);
-
-        if (reg[rsrc[0]] <= VLMAX) {
-          c.vl = reg[rsrc[0]];
-        } else if (reg[rsrc[0]] < 2 * VLMAX) {
-          c.vl = (int)ceil((reg[rsrc[0]] * 1.0) / 2.0);
-          D(3, "Length:" << c.vl << ceil(reg[rsrc[0]] / 2));
-        } else if (reg[rsrc[0]] >= (2 * VLMAX)) {
-          c.vl = VLMAX;
-        }
-        reg[rdest] = c.vl;
-        D(3, "VL:" << reg[rdest]);
-
-        Word regNum(0);
-
-        c.vreg.clear();
-        for (int j = 0; j < 32; j++) {
-          c.vreg.push_back(vector<Reg<char *>>());
-          for (int i = 0; i < (c.VLEN / vsew); ++i) {
-            int *elem_ptr = (int *)malloc(vsew / 8);
-            for (int f = 0; f < (vsew / 32); f++)
-              elem_ptr[f] = 0;
-            c.vreg[j].push_back(Reg<char *>(c.id, regNum++, (char *)elem_ptr));
-          }
-        }
-      } break;
-      default: {
-        cout << "default???\n"
-             << flush;
       }
+    }
+    break;
+  case GPGPU:
+    switch (func3) {
+    case 1:
+      // WSPAWN
+      D(3, "WSPAWN: r" << rsrc[0] << ", r" << rsrc[1]);
+      trace_inst->wspawn = true;
+      num_to_wspawn = std::min<unsigned>(rs1[0], c.core->a.getNWarps());
+      D(0, "Spawning " << num_to_wspawn << " new warps at PC: " << hex << rs2[0]);
+      for (unsigned i = 1; i < num_to_wspawn; ++i) {
+        Warp &newWarp(c.core->w[i]);
+        newWarp.pc = rs2[0];
+        newWarp.tmask = 1;
+        newWarp.activeThreads = 1;
+        newWarp.supervisorMode = false;
+        newWarp.spawned = true;
+        c.core->updateActive(i);
       }
       break;
-    case VL: {
-      is_vec = true;
-      D(3, "Executing vector load");
-      VLMAX = (c.vtype.vlmul * c.VLEN) / c.vtype.vsew;
-      D(3, "lmul: " << c.vtype.vlmul << " VLEN:" << c.VLEN << "sew: " << c.vtype.vsew);
-      D(3, "src: " << rsrc[0] << " " << reg[rsrc[0]]);
-      D(3, "dest" << rdest);
-      D(3, "width" << vlsWidth);
-      vector<Reg<char *>> &vd = c.vreg[rdest];
-
-      switch (vlsWidth) {
-      case 6: //load word and unit strided (not checking for unit stride)
-      {
-        for (Word i = 0; i < c.vl; i++) {
-          memAddr = ((reg[rsrc[0]]) & 0xFFFFFFFC) + (i * c.vtype.vsew / 8);
-          data_read = c.core->mem.read(memAddr, c.supervisorMode);
-          D(3, "Mem addr: " << std::hex << memAddr << " Data read " << data_read);
-          int *result_ptr = (int *)vd[i].val;
-          *result_ptr = data_read;
-
-          trace_inst->is_lw = true;
-          trace_inst->mem_addresses[i] = memAddr;
-        }
-        /*for(Word i = c.vl; i < VLMAX; i++){
-                int * result_ptr = (int *) vd[i].val;
-                *result_ptr = 0;
-              }*/
-
-        D(3, "Vector Register state ----:");
-        // for(int i=0; i < 32; i++)
-        // {
-        //   for(int j=0; j< c.vl; j++)
-        //   {
-        //     cout << "starting iter" << endl;
-        //       if (c.vtype.vsew == 8)
-        //       {
-        //         uint8_t * ptr_val = (uint8_t *) c.vreg[i][j].val;
-        //         std::cout << "reg[" << i << "][" << j << "] = " << *ptr_val << std::endl;
-        //       } else if (c.vtype.vsew == 16)
-        //       {
-        //         uint16_t * ptr_val = (uint16_t *) c.vreg[i][j].val;
-        //         std::cout << "reg[" << i << "][" << j << "] = " << *ptr_val << std::endl;
-        //       } else if (c.vtype.vsew == 32)
-        //       {
-        //         uint32_t * ptr_val = (uint32_t *) c.vreg[i][j].val;
-        //         std::cout << "reg[" << i << "][" << j << "] = " << *ptr_val << std::endl;
-        //       }
-
-        //       cout << "Finished iter" << endl;
-        //   }
-        // }
-
-        // cout << "Finished loop" << endl;
+    case 2: {
+      // SPLIT
+      D(3, "SPLIT: r" << pred);
+      trace_inst->stall_warp = true;
+      ThreadMask taken = predMask(c.reg[pred], c.tmask);
+      if (taken == 0 || taken == c.tmask) {
+        D(3, "Unanimous pred: " << pred << "  val: " << c.reg[pred][first]);
+        DomStackEntry e(c.tmask);
+        e.uni = true;
+        c.domStack.push(e);
+        break;
       }
-      // cout << "aaaaaaaaaaaaaaaaaaaaaa" << endl;
+      // run the taken lanes first; the rest resume after the split
+      D(3, "Split: TM 0x" << hex << c.tmask << " -> 0x" << taken
+           << ", pushed 0x" << (c.tmask & ~taken) << " PC: " << c.pc << dec);
+      if (c.core->perf) c.core->perf->diverge(c.id, trace_inst->pc);
+      c.domStack.push(DomStackEntry(c.tmask));
+      c.domStack.push(DomStackEntry(c.tmask & ~taken, c.pc));
+      c.tmask = taken;
       break;
-      default: {
-        cout << "Serious default??\n"
-             << flush;
-      } break;
+    }
+    case 3:
+      // JOIN
+      D(3, "JOIN");
+      if (!c.domStack.empty() && c.domStack.top().uni) {
+        D(2, "Uni branch at join");
+        c.tmask = c.domStack.top().tmask;
+        c.domStack.pop();
+        break;
+      }
+      if (!c.domStack.top().fallThrough) {
+        nextPc = c.domStack.top().pc;
+        D(3, "join: NOT FALLTHROUGH PC: " << hex << nextPc << dec);
+        pcSet = true;
       }
+      D(3, "Join: TM 0x" << hex << c.tmask << " -> 0x" << c.domStack.top().tmask << dec);
+      c.tmask = c.domStack.top().tmask;
+      c.domStack.pop();
       break;
-    } break;
-    case VS:
-      is_vec = true;
-      VLMAX = (c.vtype.vlmul * c.VLEN) / c.vtype.vsew;
-      for (Word i = 0; i < c.vl; i++) {
-        // cout << "iter" << endl;
-        ++c.stores;
-        memAddr = reg[rsrc[0]] + (i * c.vtype.vsew / 8);
-        // std::cout << "STORE MEM ADDRESS *** : " << std::hex << memAddr << "\n";
-
-        trace_inst->is_sw = true;
-        trace_inst->mem_addresses[i] = memAddr;
-
-        switch (vlsWidth) {
-        case 6: //store word and unit strided (not checking for unit stride)
-        {
-          uint32_t *ptr_val = (uint32_t *)c.vreg[vs3][i].val;
-          D(3, "value: " << flush << (*ptr_val) << flush);
-          c.core->mem.write(memAddr, *ptr_val, c.supervisorMode, 4);
-          D(3, "store: " << memAddr << " value:" << *ptr_val << flush);
-        } break;
-        default:
-          cout << "ERROR: UNSUPPORTED S INST\n"
-               << flush;
-          std::abort();
-        }
-        // cout << "Loop finished" << endl;
-        // c.memAccesses.push_back(Warp::MemAccess(true, memAddr));
+    case 4:
+      trace_inst->stall_warp = true;
+      // is_barrier
+      D(3, "BARRIER: 0x" << hex << rs1[0] << dec << ", " << rs2[0] << " warps");
+      c.core->barrier(c.id, rs1[0], rs2[0]);
+      break;
+    case 0:
+      // TMC
+      D(3, "TMC: r" << rsrc[0]);
+      trace_inst->stall_warp = true;
+      nextActiveThreads = std::min<unsigned>(rs1[0], c.core->a.getNThds());
+      c.tmask = threadMaskLow(nextActiveThreads);
+      if (nextActiveThreads == 0) {
+        c.spawned = false;
       }
-
-      // cout << "After for loop" << endl;
       break;
     default:
-      D(3, "pc: " << hex << (c.pc - 4));
-      D(3, "aERROR: Unsupported instruction: " << *this);
-      std::abort();
+      cout << "ERROR: UNSUPPORTED GPGPU INSTRUCTION " << *this << "\n";
     }
+    break;
+  case VSET_ARITH:
+    D(3, "VSET_ARITH");
+    if (func3 == 7) {
+      // vsetvl
+      c.vtype.vill = 0; //TODO
+      c.vtype.vediv = vediv;
+      c.vtype.vsew = vsew;
+      c.vtype.vlmul = vlmul;
+
+      Word avl = rs1[first];
+      Word VLMAX = (vlmul * c.VLEN) / vsew;
+      D(3, "lmul:" << vlmul << " sew:" << vsew << " ediv: " << vediv << "rsrc" << avl << "VLMAX" << VLMAX);
+
+      if (avl <= VLMAX) {
+        c.vl = avl;
+      } else if (avl < 2 * VLMAX) {
+        c.vl = (int)ceil((avl * 1.0) / 2.0);
+        D(3, "Length:" << c.vl << ceil(avl / 2));
+      } else if (avl >= (2 * VLMAX)) {
+        c.vl = VLMAX;
+      }
+      imm = c.vl;
+      laneMap(rd, en, n, [&](Size) { return imm; });
+      D(3, "VL:" << c.vl);
 
-    // break;
-    // cout << "outside case" << endl << flush;
+      // the vector registers read as zero after a vsetvl
+      c.vreg.clear();
+      break;
+    }
+    executeVector(c, first, trace_inst);
+    break;
+  case VL:
+  case VS:
+#ifdef EXT_F_ENABLE
+    if (vlsWidth == 2) {
+      executeFloat(c, trace_inst);
+      break;
+    }
+#endif
+    executeVector(c, first, trace_inst);
+    break;
+#ifdef EXT_F_ENABLE
+  case FCI:
+  case FMADD:
+  case FMSUB:
+  case FMNMSUB:
+  case FMNMADD:
+    executeFloat(c, trace_inst);
+    break;
+#endif
+  default:
+    D(3, "pc: " << hex << (c.pc - 4));
+    D(3, "aERROR: Unsupported instruction: " << *this);
+    std::abort();
   }
 
-  // std::cout << "finished instruction" << endl << flush;
+  // x0 is hardwired to zero
+  if (rdestPresent && rdest == 0) {
+    std::fill(c.reg[0].begin(), c.reg[0].end(), 0);
+  }
 
   c.activeThreads = nextActiveThreads;
 
-  // if (nextActiveThreads != 0)
-  // {
-  //   for (int i = 7; i >= c.activeThreads; i--)
-  //   {
-  //     c.tmask[i] = c.tmask[i] && false;
-  //   }
-  // }
-
-  // //std::cout << "new thread mask: ";
-  // for (int i = 0; i < c.tmask.size(); ++i) //std::cout << " " << c.tmask[i];
-  // //std::cout << "\n";
-
   // This way, if pc was set by a side effect (such as interrupt), it will
   // retain its new value.
   if (pcSet) {
@@ -2276,9 +944,333 @@ void Instruction::executeOn(Warp &c, trace_inst_t *trace_inst) {
     D(3, "Next PC: " << hex << nextPc << dec);
   }
 
-  if (nextActiveThreads > c.reg.size()) {
+  if (nextActiveThreads > n) {
     cerr << "Error: attempt to spawn " << nextActiveThreads << " threads. "
-         << c.reg.size() << " available.\n";
+         << n << " available.\n";
     abort();
   }
 }
+
+void Instruction::executeFloat(Warp &c, trace_inst_t *trace_inst) {
+  using namespace FPU;
+
+  Size n = c.core->a.getNThds();
+  ThreadMask en = c.tmask & threadMaskLow(c.activeThreads);
+
+  /* Integer and float views of the operands; each op picks its own. */
+  const Word *rs1 = &c.reg[rsrc[0]][0];
+  const Word *fs1 = &c.freg[rsrc[0]][0];
+  const Word *fs2 = (nRsrc > 1) ? &c.freg[rsrc[1]][0] : NULL;
+  const Word *fs3 = (nRsrc > 2) ? &c.freg[rsrc[2]][0] : NULL;
+  Word *rd = rdestPresent ? &c.reg[rdest][0] : NULL;
+  Word *fd = rdestPresent ? &c.freg[rdest][0] : NULL;
+
+  if (op == VL) {
+    D(3, "FLW: f" << rdest << " <- r" << rsrc[0] << ", imm=" << (int)immsrc);
+    trace_inst->is_lw = true;
+    laneLoad(c, fd, rs1, immsrc, en, trace_inst, [](Word d, Word) { return d; });
+    return;
+  }
+  if (op == VS) {
+    D(3, "FSW: f" << rsrc[1] << " -> r" << rsrc[0] << ", imm=" << (int)immsrc);
+    trace_inst->is_sw = true;
+    laneStore(c, rs1, fs2, immsrc, 4, 0xFFFFFFFF, en, trace_inst);
+    return;
+  }
+
+  Word rm = (func3 == DYN) ? (c.fcsr >> 5) & 0x7 : func3;
+  Scope fp(rm);
+  int latency = LATENCY_FNONCOMP;
+
+  switch (op) {
+  case FMADD:
+    D(3, "FMADD: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1] << ", f" << rsrc[2]);
+    latency = LATENCY_FMADD;
+    laneMap(fd, en, n, [&](Size t) {
+      return result(fmaf(toFloat(fs1[t]), toFloat(fs2[t]), toFloat(fs3[t])));
+    });
+    break;
+  case FMSUB:
+    D(3, "FMSUB: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1] << ", f" << rsrc[2]);
+    latency = LATENCY_FMADD;
+    laneMap(fd, en, n, [&](Size t) {
+      return result(fmaf(toFloat(fs1[t]), toFloat(fs2[t]), -toFloat(fs3[t])));
+    });
+    break;
+  case FMNMSUB:
+    D(3, "FNMSUB: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1] << ", f" << rsrc[2]);
+    latency = LATENCY_FMADD;
+    laneMap(fd, en, n, [&](Size t) {
+      return result(fmaf(-toFloat(fs1[t]), toFloat(fs2[t]), toFloat(fs3[t])));
+    });
+    break;
+  case FMNMADD:
+    D(3, "FNMADD: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1] << ", f" << rsrc[2]);
+    latency = LATENCY_FMADD;
+    laneMap(fd, en, n, [&](Size t) {
+      return result(fmaf(-toFloat(fs1[t]), toFloat(fs2[t]), -toFloat(fs3[t])));
+    });
+    break;
+  case FCI:
+    switch (func7) {
+    case 0x00:
+      D(3, "FADD: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1]);
+      latency = LATENCY_FADDMUL;
+      laneMap(fd, en, n, [&](Size t) { return result(toFloat(fs1[t]) + toFloat(fs2[t])); });
+      break;
+    case 0x04:
+      D(3, "FSUB: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1]);
+      latency = LATENCY_FADDMUL;
+      laneMap(fd, en, n, [&](Size t) { return result(toFloat(fs1[t]) - toFloat(fs2[t])); });
+      break;
+    case 0x08:
+      D(3, "FMUL: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1]);
+      latency = LATENCY_FADDMUL;
+      laneMap(fd, en, n, [&](Size t) { return result(toFloat(fs1[t]) * toFloat(fs2[t])); });
+      break;
+    case 0x0c:
+      D(3, "FDIV: f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1]);
+      latency = LATENCY_FDIV;
+      laneMap(fd, en, n, [&](Size t) { return result(toFloat(fs1[t]) / toFloat(fs2[t])); });
+      break;
+    case 0x2c:
+      D(3, "FSQRT: f" << rdest << " <- f" << rsrc[0]);
+      latency = LATENCY_FSQRT;
+      laneMap(fd, en, n, [&](Size t) { return result(sqrtf(toFloat(fs1[t]))); });
+      break;
+    case 0x10:
+      // FSGNJ, FSGNJN, FSGNJX
+      D(3, "FSGNJ" << func3 << ": f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1]);
+      laneMap(fd, en, n, [&](Size t) -> Word {
+        Word sign = fs2[t] & 0x80000000;
+        if (func3 == 1) sign ^= 0x80000000;
+        if (func3 == 2) sign ^= fs1[t] & 0x80000000;
+        return (fs1[t] & 0x7fffffff) | sign;
+      });
+      break;
+    case 0x14:
+      // FMIN, FMAX
+      D(3, "FMINMAX" << func3 << ": f" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1]);
+      laneMap(fd, en, n, [&](Size t) { return minMax(fs1[t], fs2[t], func3 == 1); });
+      break;
+    case 0x50:
+      // FLE, FLT, FEQ
+      D(3, "FCMP" << func3 << ": r" << rdest << " <- f" << rsrc[0] << ", f" << rsrc[1]);
+      laneMap(rd, en, n, [&](Size t) { return compare(fs1[t], fs2[t], func3); });
+      break;
+    case 0x60: {
+      // FCVT.W.S, FCVT.WU.S
+      D(3, "FCVT.W" << (rsrc[1] ? "U" : "") << ".S: r" << rdest << " <- f" << rsrc[0]);
+      latency = LATENCY_FTOI;
+      bool isUnsigned = rsrc[1] & 1;
+      laneMap(rd, en, n, [&](Size t) { return toInt(fs1[t], isUnsigned, rm); });
+    } break;
+    case 0x68:
+      // FCVT.S.W, FCVT.S.WU
+      D(3, "FCVT.S.W" << (rsrc[1] ? "U" : "") << ": f" << rdest << " <- r" << rsrc[0]);
+      latency = LATENCY_ITOF;
+      if (rsrc[1] & 1)
+        laneMap(fd, en, n, [&](Size t) { return result(float(rs1[t])); });
+      else
+        laneMap(fd, en, n, [&](Size t) { return result(float(Word_s(rs1[t]))); });
+      break;
+    case 0x70:
+      // FMV.X.W, FCLASS.S
+      D(3, (func3 ? "FCLASS" : "FMV.X.W") << ": r" << rdest << " <- f" << rsrc[0]);
+      if (func3 == 1)
+        laneMap(rd, en, n, [&](Size t) { return classify(fs1[t]); });
+      else
+        laneMap(rd, en, n, [&](Size t) { return fs1[t]; });
+      break;
+    case 0x78:
+      // FMV.W.X
+      D(3, "FMV.W.X: f" << rdest << " <- r" << rsrc[0]);
+      laneMap(fd, en, n, [&](Size t) { return rs1[t]; });
+      break;
+    default:
+      cout << "ERROR: UNSUPPORTED FP INSTRUCTION " << *this << "\n";
+      std::abort();
+    }
+    break;
+  default:
+    break;
+  }
+
+  c.fcsr |= fp.flags();
+  trace_inst->exe_stall_cycles = latency - 1;
+}
+
+void Instruction::executeVector(Warp &c, Size t, trace_inst_t *trace_inst) {
+  switch (c.vtype.vsew) {
+  case 8:  executeVector<uint8_t, int8_t>(c, t, trace_inst); break;
+  case 16: executeVector<uint16_t, int16_t>(c, t, trace_inst); break;
+  case 32: executeVector<uint32_t, int32_t>(c, t, trace_inst); break;
+  default:
+    cout << "ERROR: unsupported vector element width " << c.vtype.vsew << "\n";
+    std::abort();
+  }
+}
+
+template <typename U, typename S>
+void Instruction::executeVector(Warp &c, Size t, trace_inst_t *trace_inst) {
+  Size vl = c.vl;
+  Size VLMAX = (c.vtype.vlmul * c.VLEN) / c.vtype.vsew;
+
+  switch (op) {
+  case VSET_ARITH: {
+    U *vd = c.vreg.get<U>(rdest);
+    const U *vs1 = c.vreg.get<U>(rsrc[0]);
+    const U *vs2 = c.vreg.get<U>(rsrc[1]);
+    const S *svs1 = (const S *)vs1;
+    const S *svs2 = (const S *)vs2;
+    S *svd = (S *)vd;
+
+    switch (func3) {
+    case 0: // vector-vector
+      trace_inst->vs1 = rsrc[0];
+      trace_inst->vs2 = rsrc[1];
+      trace_inst->vd = rdest;
+      switch (func6) {
+      case 0: // vadd
+        D(3, "Addition " << rsrc[0] << " " << rsrc[1] << " Dest:" << rdest);
+        if (vmask) {
+          VecOps::add(vd, vs1, vs2, vl);
+        } else {
+          VecOps::mapMasked(vd, vs1, vs2, c.vreg.get<U>(0), vl, [](U a, U b) -> U { return a + b; });
+        }
+        break;
+      case 24: // vmseq
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return a == b; });
+        break;
+      case 25: // vmsne
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return a != b; });
+        break;
+      case 26: // vmsltu
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return a < b; });
+        break;
+      case 27: // vmslt
+        VecOps::map(svd, svs1, svs2, vl, [](S a, S b) -> S { return a < b; });
+        break;
+      case 28: // vmsleu
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return a <= b; });
+        break;
+      case 29: // vmsle
+        VecOps::map(svd, svs1, svs2, vl, [](S a, S b) -> S { return a <= b; });
+        break;
+      case 30: // vmsgtu
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return a > b; });
+        break;
+      case 31: // vmsgt
+        VecOps::map(svd, svs1, svs2, vl, [](S a, S b) -> S { return a > b; });
+        break;
+      }
+      break;
+    case 2: // mask logical, vmul, vmacc
+      trace_inst->vs1 = rsrc[0];
+      trace_inst->vs2 = rsrc[1];
+      trace_inst->vd = rdest;
+      switch (func6) {
+      case 24: // vmandnot
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return (a & 1) & !(b & 1); });
+        break;
+      case 25: // vmand
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return (a & 1) & (b & 1); });
+        break;
+      case 26: // vmor
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return (a & 1) | (b & 1); });
+        break;
+      case 27: // vmxor
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return (a & 1) ^ (b & 1); });
+        break;
+      case 28: // vmornot
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return (a & 1) | !(b & 1); });
+        break;
+      case 29: // vmnand
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return !((a & 1) & (b & 1)); });
+        break;
+      case 30: // vmnor
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return !((a & 1) | (b & 1)); });
+        break;
+      case 31: // vmxnor
+        VecOps::map(vd, vs1, vs2, vl, [](U a, U b) -> U { return !((a & 1) ^ (b & 1)); });
+        break;
+      case 37: // vmul
+        VecOps::mul(vd, vs1, vs2, vl);
+        break;
+      case 45: // vmacc
+        VecOps::macc(vd, vs1, vs2, vl);
+        break;
+      default:
+        return;
+      }
+      VecOps::zeroTail(vd, vl, VLMAX);
+      break;
+    case 6: // vector-scalar
+      switch (func6) {
+      case 0: // vadd.vx
+        D(3, "vadd.vx");
+        VecOps::addScalar(vd, (U)c.reg[rsrc[0]][t], vs2, vl);
+        break;
+      case 37: // vmul.vx
+        D(3, "vmul.vx");
+        VecOps::mulScalar(vd, (U)c.reg[rsrc[0]][t], vs2, vl);
+        break;
+      default:
+        return;
+      }
+      VecOps::zeroTail(vd, vl, VLMAX);
+      break;
+    default:
+      cout << "default???\n" << flush;
+    }
+    D(3, "v" << rdest << "[0] = " << (Word)vd[0]);
+  } break;
+  case VL: {
+    D(3, "Executing vector load");
+    D(3, "lmul: " << c.vtype.vlmul << " VLEN:" << c.VLEN << "sew: " << c.vtype.vsew);
+    D(3, "src: " << rsrc[0] << " " << c.reg[rsrc[0]][t]);
+    D(3, "dest" << rdest);
+    D(3, "width" << vlsWidth);
+    U *vd = c.vreg.get<U>(rdest);
+
+    switch (vlsWidth) {
+    case 6: //load word and unit strided (not checking for unit stride)
+    {
+      Word base = c.reg[rsrc[0]][t] & 0xFFFFFFFC;
+      for (Size i = 0; i < vl; i++) {
+        Word memAddr = base + i * sizeof(U);
+        vd[i] = (U)c.core->mem.read(memAddr, c.supervisorMode);
+        D(3, "Mem addr: " << std::hex << memAddr << " Data read " << (Word)vd[i]);
+        trace_inst->is_lw = true;
+        if (i < 32) trace_inst->mem_addresses[i] = memAddr;
+      }
+    } break;
+    default:
+      cout << "Serious default??\n" << flush;
+      break;
+    }
+  } break;
+  case VS: {
+    const U *vs = c.vreg.get<U>(vs3);
+    for (Size i = 0; i < vl; i++) {
+      ++c.stores;
+      Word memAddr = c.reg[rsrc[0]][t] + i * sizeof(U);
+
+      trace_inst->is_sw = true;
+      if (i < 32) trace_inst->mem_addresses[i] = memAddr;
+
+      switch (vlsWidth) {
+      case 6: //store word and unit strided (not checking for unit stride)
+        D(3, "store: " << memAddr << " value:" << (Word)vs[i] << flush);
+        c.core->mem.write(memAddr, vs[i], c.supervisorMode, sizeof(U));
+        break;
+      default:
+        cout << "ERROR: UNSUPPORTED S INST\n" << flush;
+        std::abort();
+      }
+    }
+  } break;
+  default:
+    break;
+  }
+}
@@ -13,7 +13,9 @@
 #include "include/types.h"
 #include "include/util.h"
 #include "include/mem.h"
+#include "include/checkpoint.h"
 #include "include/core.h"
+#include "include/decode_cache.h"
 
 using namespace std;
 using namespace Harp;
@@ -96,7 +98,7 @@ void MemoryUnit::ADecoder::write(Addr a, Word w, bool sup, Size wordSize) {
   Size bit = wordSize - 1;
   MemDevice &m(doLookup(a, bit));
 
-  RAM & r = (RAM &) m;
+  Harp::RAM & r = (Harp::RAM &) m;
   // a &= (2<<bit)-1;
   // std::cout << std::hex << "ADecoder::write(Addr " << a << ", w " << w << ", sup " << sup << ", wordSize " << wordSize << "\n";
   Word before = m.read(a);
@@ -194,15 +196,66 @@ void MemoryUnit::write(Addr vAddr, Word w, bool sup, Size bytes) {
   // std::cout << "MU::write: About to write: " << std::hex << pAddr << " = " << w << " with " << std::dec << 8*bytes << "\n";
   ad.write(pAddr, w, sup, 8*bytes);
   // std::cout << std::hex << "reading same address: " << (this->read(vAddr, sup)) << "\n";
+
+  Addr page = vAddr >> DecodeCache::PAGE_BITS;
+  uint64_t pageBit = 1ull << (page & 63);
+  if (codePages[page >> 6] & pageBit) {
+    codePages[page >> 6] &= ~pageBit;
+    for (size_t i = 0; i < decodeCaches.size(); ++i)
+      decodeCaches[i]->invalidate(page);
+  }
+}
+
+void MemoryUnit::attachDecodeCache(DecodeCache *dc) {
+  decodeCaches.push_back(dc);
+}
+
+void MemoryUnit::detachDecodeCache(DecodeCache *dc) {
+  for (size_t i = 0; i < decodeCaches.size(); ++i) {
+    if (decodeCaches[i] == dc) {
+      decodeCaches.erase(decodeCaches.begin() + i);
+      break;
+    }
+  }
+}
+
+void MemoryUnit::invalidateCode() {
+  for (size_t i = 0; i < codePages.size(); ++i) codePages[i] = 0;
+  for (size_t i = 0; i < decodeCaches.size(); ++i)
+    decodeCaches[i]->invalidateAll();
 }
 
 void MemoryUnit::tlbAdd(Addr virt, Addr phys, Word flags) {
   D(1, "tlbAdd(0x" << hex << virt << ", 0x" << phys << ", 0x" << flags << ')');
   tlb[virt/pageSize] = TLBEntry(phys/pageSize, flags);
+  invalidateCode();
 }
 
 void MemoryUnit::tlbRm(Addr va) {
   if (tlb.find(va/pageSize) != tlb.end()) tlb.erase(tlb.find(va/pageSize));
+  invalidateCode();
+}
+
+void MemoryUnit::save(CheckpointWriter &w) const {
+  w.put<uint64_t>(tlb.size());
+  for (auto &e : tlb) {
+    w.put(e.first);
+    w.put(e.second);
+  }
+}
+
+void MemoryUnit::restore(CheckpointReader &r) {
+  uint64_t n = 0;
+  r.get(n);
+  tlb.clear();
+  for (uint64_t i = 0; r.ok && i < n; ++i) {
+    Addr page;
+    TLBEntry e;
+    r.get(page);
+    r.get(e);
+    tlb[page] = e;
+  }
+  invalidateCode();
 }
 
 void *Harp::consoleInputThread(void* arg_vp) {
@@ -296,7 +349,7 @@ static uint32_t hToI_old(char *c, uint32_t size) {
     return value;
 }
 
-void RAM::loadHexImpl(std::string path) {
+void Harp::RAM::loadHexImpl(std::string path) {
       this->clear();
       FILE *fp = fopen(&path[0], "r");
       if(fp == 0){
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "include/perf.h"
+
+using namespace Harp;
+using namespace std;
+
+const char *Harp::stallReasonNames[STALL_NUM_REASONS] = {
+  "scoreboard", "lsu", "icache", "dcache", "exe", "barrier", "control", "issue"
+};
+
+WarpPerf::WarpPerf() :
+  issued(0), stalled(0), idle(0), instructions(0), lanes(0), loads(0),
+  stores(0), divergences(0)
+{
+  for (int i = 0; i < STALL_NUM_REASONS; ++i) stalls[i] = 0;
+}
+
+static vector<Word> sortedPcs(const unordered_map<Word, PcPerf> &pcs) {
+  vector<Word> v;
+  v.reserve(pcs.size());
+  for (auto &e : pcs) v.push_back(e.first);
+  sort(v.begin(), v.end());
+  return v;
+}
+
+void PerfCounters::writeJson(ostream &os) const {
+  uint64_t instructions = 0;
+  for (auto &w : warps) instructions += w.instructions;
+
+  os << "{\"core\": " << core << ", \"cycles\": " << cycles
+     << ", \"instructions\": " << instructions << ",\n   \"warps\": [";
+  for (Size i = 0; i < warps.size(); ++i) {
+    const WarpPerf &w = warps[i];
+    os << (i ? ",\n" : "\n") << "    {\"id\": " << i
+       << ", \"issued\": " << w.issued << ", \"stalled\": " << w.stalled
+       << ", \"idle\": " << w.idle << ", \"instructions\": " << w.instructions
+       << ", \"lanes\": " << w.lanes << ", \"loads\": " << w.loads
+       << ", \"stores\": " << w.stores << ", \"divergences\": " << w.divergences
+       << ", \"stalls\": {";
+    for (int r = 0; r < STALL_NUM_REASONS; ++r)
+      os << (r ? ", \"" : "\"") << stallReasonNames[r] << "\": " << w.stalls[r];
+    os << "}}";
+  }
+  os << "]}";
+}
+
+void PerfCounters::writeFlat(ostream &os) const {
+  for (Word pc : sortedPcs(pcs)) {
+    const PcPerf &p = pcs.at(pc);
+    os << core << ' ' << hex << pc << dec << ' ' << p.count << ' ' << p.lanes
+       << ' ' << p.divergences << ' ' << p.stalls << '\n';
+  }
+}
+
+void PerfCounters::printSummary(ostream &os) const {
+  os << "core " << core << ": " << cycles << " cycles\n"
+     << "warp    issued   stalled      idle    instrs  diverge";
+  for (int r = 0; r < STALL_NUM_REASONS; ++r)
+    os << setw(11) << stallReasonNames[r];
+  os << '\n';
+  for (Size i = 0; i < warps.size(); ++i) {
+    const WarpPerf &w = warps[i];
+    os << setw(4) << i << setw(10) << w.issued << setw(10) << w.stalled
+       << setw(10) << w.idle << setw(10) << w.instructions
+       << setw(9) << w.divergences;
+    for (int r = 0; r < STALL_NUM_REASONS; ++r) os << setw(11) << w.stalls[r];
+    os << '\n';
+  }
+}
+
+bool Harp::writeProfile(const string &prefix,
+                        const vector<const PerfCounters *> &cores)
+{
+  ofstream json((prefix + ".json").c_str()), flat((prefix + ".prof").c_str());
+  if (!json || !flat) {
+    cerr << "Warning: cannot write profile " << prefix << ".{json,prof}\n";
+    return false;
+  }
+
+  json << "{\"cores\": [";
+  bool first = true;
+  for (const PerfCounters *p : cores) {
+    if (!p) continue;
+    json << (first ? "\n  " : ",\n  ");
+    p->writeJson(json);
+    first = false;
+  }
+  json << "\n]}\n";
+
+  flat << "# core pc count lanes divergences stalls\n";
+  for (const PerfCounters *p : cores)
+    if (p) p->writeFlat(flat);
+
+  return true;
+}
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "include/scheduler.h"
+#include "include/checkpoint.h"
+
+using namespace Harp;
+using namespace std;
+
+/* Mask of warps [0, n). */
+static WarpMask warpsBelow(Size n) {
+  return (n >= MAX_WARPS) ? ~WarpMask(0) : (WarpMask(1) << n) - 1;
+}
+
+/* First warp of m at or after from, wrapping around. m is not empty. */
+static int firstFrom(WarpMask m, Size from) {
+  WarpMask later = m & ~warpsBelow(from);
+  return __builtin_ctz(later ? later : m);
+}
+
+void WarpScheduler::printStats(ostream &os, uint64_t cycles) const {
+  os << "scheduler: policy=" << name()
+     << " ipc=" << (cycles ? double(issued) / cycles : 0.0)
+     << " issued=" << issued << " switches=" << switches
+     << " no_ready=" << noReady << " blocked=" << blocked << endl;
+}
+
+void WarpScheduler::save(CheckpointWriter &w) const {
+  w.put(issued);
+  w.put(switches);
+  w.put(noReady);
+  w.put(blocked);
+  w.put(lastIssued);
+}
+
+void WarpScheduler::restore(CheckpointReader &r) {
+  r.get(issued);
+  r.get(switches);
+  r.get(noReady);
+  r.get(blocked);
+  r.get(lastIssued);
+}
+
+void LrrScheduler::save(CheckpointWriter &w) const {
+  WarpScheduler::save(w);
+  w.put(last);
+}
+
+void LrrScheduler::restore(CheckpointReader &r) {
+  WarpScheduler::restore(r);
+  r.get(last);
+}
+
+int LrrScheduler::pick(WarpMask ready) {
+  Size next = (last + 1) % nWarps;
+  if (!ready) {
+    last = next;
+    return -1;
+  }
+  return last = firstFrom(ready, next);
+}
+
+void GtoScheduler::save(CheckpointWriter &w) const {
+  WarpScheduler::save(w);
+  w.put(last);
+}
+
+void GtoScheduler::restore(CheckpointReader &r) {
+  WarpScheduler::restore(r);
+  r.get(last);
+}
+
+int GtoScheduler::pick(WarpMask ready) {
+  if (!ready) return -1;
+  if (!((ready >> last) & 1)) last = __builtin_ctz(ready);
+  return last;
+}
+
+TwoLevelScheduler::TwoLevelScheduler(Size nWarps, Size groupSize) :
+  WarpScheduler(nWarps), groupSize(groupSize),
+  nGroups((nWarps + groupSize - 1) / groupSize), group(0), last(0)
+{}
+
+void TwoLevelScheduler::save(CheckpointWriter &w) const {
+  WarpScheduler::save(w);
+  w.put(groupSize);
+  w.put(group);
+  w.put(last);
+}
+
+void TwoLevelScheduler::restore(CheckpointReader &r) {
+  WarpScheduler::restore(r);
+  Size savedGroupSize = 0, savedGroup = 0;
+  int savedLast = 0;
+  r.get(savedGroupSize);
+  r.get(savedGroup);
+  r.get(savedLast);
+  // Another group size is another policy: keep the fresh position
+  if (savedGroupSize == groupSize) {
+    group = savedGroup;
+    last = savedLast;
+  }
+}
+
+int TwoLevelScheduler::pick(WarpMask ready) {
+  for (Size i = 0; i < nGroups; ++i) {
+    Size g = (group + i) % nGroups;
+    WarpMask members = ready & warpsBelow((g + 1) * groupSize)
+                             & ~warpsBelow(g * groupSize);
+    if (!members) continue;
+    group = g;
+    return last = firstFrom(members, last + 1);
+  }
+  return -1;
+}
+
+WarpScheduler *Harp::makeScheduler(const string &policy, Size nWarps) {
+  if (policy == "lrr") return new LrrScheduler(nWarps);
+  if (policy == "gto") return new GtoScheduler(nWarps);
+
+  string twoLevel("twolevel");
+  if (policy.compare(0, twoLevel.size(), twoLevel) != 0) return NULL;
+  Size groupSize = 4;
+  if (policy.size() > twoLevel.size()) {
+    if (policy[twoLevel.size()] != ':') return NULL;
+    const char *arg = policy.c_str() + twoLevel.size() + 1;
+    if (!isdigit((unsigned char)*arg)) return NULL;
+    char *end;
+    unsigned long n = strtoul(arg, &end, 10);
+    if (*end != '\0' || n < 1 || n > MAX_WARPS) return NULL;
+    groupSize = n;
+  }
+  return new TwoLevelScheduler(nWarps, groupSize);
+}
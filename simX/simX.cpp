@@ -24,6 +24,8 @@
 #include <VX_config.h>
 
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 //////////////
 /////////////
@@ -32,6 +34,17 @@ using namespace Harp;
 using namespace HarpTools;
 using namespace std; 
 
+/* Checkpoint from a fork()ed child: it writes a copy-on-write image of the
+   simulator while the parent keeps simulating. Returns the child's pid, or
+   0 once the checkpoint has been written in-process. */
+static pid_t forkCheckpoint(const string &path, const Core &core, const Harp::RAM &ram) {
+  cout << flush;
+  pid_t pid = fork();
+  if (pid == 0) _exit(saveCheckpoint(path, core, ram) ? 0 : 1);
+  if (pid < 0) saveCheckpoint(path, core, ram);
+  return (pid < 0) ? 0 : pid;
+}
+
 enum HarpToolMode { HARPTOOL_MODE_ASM, HARPTOOL_MODE_DISASM, HARPTOOL_MODE_EMU, 
                     HARPTOOL_MODE_LD,  HARPTOOL_MODE_HELP };
 
@@ -59,9 +72,14 @@ HarpToolMode findMode(int argc, char** argv) {
 int emu_main(int argc, char **argv) {
     string archString("rv32i");
     string imgFileName("a.dsfsdout.bin");
-    bool showHelp(false), showStats(false), basicMachine(true);
+    bool showHelp(false), showStats(false), basicMachine(true), functional(false);
     int max_warps(NUM_WARPS);
     int max_threads(NUM_THREADS);
+    string traceFileName, traceEvents("stage,retire");
+    string profilePrefix;
+    string schedPolicy("lrr");
+    string checkpointFile("simX.ckpt"), restoreFile;
+    unsigned long checkpointAt(0);
 
     /* Read the command line arguments. */
     CommandLineArgFlag          fh("-h", "--help", "", showHelp);
@@ -71,6 +89,14 @@ int emu_main(int argc, char **argv) {
     CommandLineArgFlag          fb("-b", "--basic", "", basicMachine);
     CommandLineArgSetter<int>   fw("-w", "--warps", "", max_warps);
     CommandLineArgSetter<int>   ft("-t", "--threads", "", max_threads);
+    CommandLineArgFlag          ff("-f", "--functional", "", functional);
+    CommandLineArgSetter<string>fT("-T", "--trace", "", traceFileName);
+    CommandLineArgSetter<string>fe("-e", "--trace-events", "", traceEvents);
+    CommandLineArgSetter<string>fp("-p", "--profile", "", profilePrefix);
+    CommandLineArgSetter<string>fS("-S", "--scheduler", "", schedPolicy);
+    CommandLineArgSetter<unsigned long>fC("--checkpoint-at", "", checkpointAt);
+    CommandLineArgSetter<string>fF("--checkpoint", "", checkpointFile);
+    CommandLineArgSetter<string>fR("--restore", "", restoreFile);
     
     CommandLineArg::readArgs(argc, argv);
     
@@ -95,12 +121,31 @@ int emu_main(int argc, char **argv) {
 
     // std::cout << "TESTING:  " << tests[t] << "\n"; 
 
+    // The sink outlives the core, which flushes into it on destruction
+    unsigned traceMask = 0;
+    if (traceEvents.find("stage") != string::npos)  traceMask |= 1 << TRACE_STAGE;
+    if (traceEvents.find("retire") != string::npos) traceMask |= 1 << TRACE_RETIRE;
+    unique_ptr<TraceSink> trace;
+    if (!traceFileName.empty())
+      trace.reset(new TraceSink(traceFileName.c_str(), traceMask));
+
     MemoryUnit mu(4096, arch.getWordSize(), basicMachine);
     Core core(arch, *dec, mu/*, ID in multicore implementations*/);
+    core.functional = functional;
+    if (!core.setScheduler(schedPolicy)) {
+      cout << "Unrecognized scheduling policy: '" << schedPolicy << "'.\n";
+      return 1;
+    }
+    core.setTrace(trace.get());
+    if (!profilePrefix.empty()) core.enableProfile();
 
     // RamMemDevice mem(imgFileName.c_str(), arch.getWordSize());
-    RAM old_ram;
-    old_ram.loadHexImpl(imgFileName.c_str());
+    Harp::RAM old_ram;
+    if (restoreFile.empty()) {
+      old_ram.loadHexImpl(imgFileName.c_str());
+    } else if (!restoreCheckpoint(restoreFile, core, old_ram)) {
+      return 1;
+    }
     // old_ram.loadHexImpl(tests[t]);
     // MemDevice * memory = &old_ram;
 
@@ -133,9 +178,25 @@ int emu_main(int argc, char **argv) {
     struct stat hello;
     fstat(0, &hello);
 
-    while (core.running()) {core.step(); }
+    pid_t checkpointer = 0;
+    bool checkpointed = (checkpointAt == 0);
+    while (core.running()) {
+      if (!checkpointed && core.num_cycles == checkpointAt) {
+        checkpointer = forkCheckpoint(checkpointFile, core, old_ram);
+        checkpointed = true;
+      }
+      core.step();
+    }
+    if (!checkpointed)
+      cerr << "Warning: finished after " << core.num_cycles << " cycles, before "
+           << "--checkpoint-at " << checkpointAt << "\n";
+
+    int status = 0;
+    if (checkpointer > 0 && (waitpid(checkpointer, &status, 0) < 0 || status != 0))
+      cerr << "Warning: checkpoint " << checkpointFile << " failed\n";
 
     if (showStats) core.printStats();
+    if (core.perf) writeProfile(profilePrefix, { core.perf.get() });
 
 
     std::cout << "\n";
@@ -145,9 +206,6 @@ int emu_main(int argc, char **argv) {
 
 int main(int argc, char** argv) {
 
-  Verilated::commandArgs(argc, argv);
-  Verilated::traceEverOn(true);
-
   try {
     switch (findMode(argc - 1, argv + 1)) {
     case HARPTOOL_MODE_ASM:    
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+/* Offline decoder for the binary traces written by simX --trace or the simx
+   driver's VX_SIMX_TRACE. Prints the records that pass the filters, one per
+   line, or a per-warp summary. */
+#include <stdio.h>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <map>
+#include <utility>
+
+#include "include/args.h"
+#include "include/trace_sink.h"
+
+using namespace Harp;
+using namespace HarpTools;
+using namespace std;
+
+static const char *stageNames[TRACE_NUM_STAGES] = {
+  "fetch", "decode", "schedule", "execute", "lsu", "writeback"
+};
+
+static const char *helpText =
+  "simX trace decoder:\n"
+  "  -i, --input <filename>   Trace file\n"
+  "  -c, --core <n>           Only core n\n"
+  "  -w, --warp <n>           Only warp n\n"
+  "  -e, --events <list>      Events to show: stage, retire (default both)\n"
+  "  -s, --summary            Per-warp counts instead of records\n";
+
+static void printRecord(const TraceRecord &r) {
+  cout << setw(10) << r.cycle << " c" << r.core << " w" << unsigned(r.wid) << ' ';
+  if (r.type == TRACE_RETIRE) {
+    cout << "retire   ";
+  } else {
+    cout << left << setw(9) << (r.stage < TRACE_NUM_STAGES ? stageNames[r.stage] : "?")
+         << right;
+  }
+  cout << " pc=0x" << hex << setfill('0') << setw(8) << r.pc;
+  if (r.type == TRACE_RETIRE) cout << " tmask=0x" << setw(8) << r.tmask;
+  cout << setfill(' ') << dec
+       << " rd=" << int(r.rd) << " rs1=" << int(r.rs1) << " rs2=" << int(r.rs2);
+  if (r.fetch_stall) cout << " fetch_stall=" << r.fetch_stall;
+  if (r.mem_stall)   cout << " mem_stall=" << r.mem_stall;
+  if (r.flags & TRACE_F_LOAD)       cout << " load";
+  if (r.flags & TRACE_F_STORE)      cout << " store";
+  if (r.flags & TRACE_F_STALL_WARP) cout << " stall_warp";
+  if (r.flags & TRACE_F_WSPAWN)     cout << " wspawn";
+  if (r.flags & TRACE_F_STALLED)    cout << " stalled";
+  cout << '\n';
+}
+
+int main(int argc, char **argv) {
+  string fileName, events("stage,retire");
+  int core(-1), warp(-1);
+  bool showHelp(false), summary(false);
+
+  try {
+    CommandLineArgFlag          fh("-h", "--help", "", showHelp);
+    CommandLineArgSetter<string>fi("-i", "--input", "", fileName);
+    CommandLineArgSetter<int>   fc("-c", "--core", "", core);
+    CommandLineArgSetter<int>   fw("-w", "--warp", "", warp);
+    CommandLineArgSetter<string>fe("-e", "--events", "", events);
+    CommandLineArgFlag          fs("-s", "--summary", "", summary);
+    CommandLineArg::readArgs(argc - 1, argv + 1);
+  } catch (BadArg ba) {
+    cout << "Unrecognized argument \"" << ba.arg << "\".\n";
+    return 1;
+  }
+
+  if (showHelp || fileName.empty()) {
+    cout << helpText;
+    return showHelp ? 0 : 1;
+  }
+
+  bool showStages = (events.find("stage") != string::npos);
+  bool showRetires = (events.find("retire") != string::npos);
+
+  FILE *f = fopen(fileName.c_str(), "rb");
+  if (!f) {
+    cerr << "Cannot open " << fileName << "\n";
+    return 1;
+  }
+
+  TraceFileHeader h;
+  if (fread(&h, sizeof(h), 1, f) != 1 || h.magic != TRACE_MAGIC) {
+    cerr << fileName << " is not a simX trace\n";
+    return 1;
+  }
+  if (h.version != TRACE_VERSION || h.record_size != sizeof(TraceRecord)) {
+    cerr << fileName << ": unsupported trace version " << h.version << "\n";
+    return 1;
+  }
+
+  struct Counts {
+    Counts() : retired(0), lanes(0), loads(0), stores(0), stalled(0) {}
+    unsigned long retired, lanes, loads, stores, stalled;
+  };
+  map<pair<unsigned, unsigned>, Counts> counts;
+
+  static const size_t CHUNK = 4096;
+  TraceRecord buffer[CHUNK];
+  size_t n;
+  while ((n = fread(buffer, sizeof(TraceRecord), CHUNK, f)) > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      const TraceRecord &r = buffer[i];
+      if (core >= 0 && r.core != core) continue;
+      if (warp >= 0 && r.wid != warp) continue;
+      if (r.type == TRACE_STAGE ? !showStages : !showRetires) continue;
+
+      if (!summary) {
+        printRecord(r);
+        continue;
+      }
+
+      Counts &c = counts[make_pair(unsigned(r.core), unsigned(r.wid))];
+      if (r.type == TRACE_RETIRE) {
+        ++c.retired;
+        c.lanes += __builtin_popcount(r.tmask);
+        if (r.flags & TRACE_F_LOAD)  ++c.loads;
+        if (r.flags & TRACE_F_STORE) ++c.stores;
+      } else if (r.flags & TRACE_F_STALLED) {
+        ++c.stalled;
+      }
+    }
+  }
+  fclose(f);
+
+  if (summary) {
+    cout << "core warp    retired      lanes      loads     stores  stalled\n";
+    for (auto &e : counts) {
+      const Counts &c = e.second;
+      cout << setw(4) << e.first.first << setw(5) << e.first.second
+           << setw(11) << c.retired << setw(11) << c.lanes
+           << setw(11) << c.loads << setw(11) << c.stores
+           << setw(9) << c.stalled << '\n';
+    }
+  }
+
+  return 0;
+}
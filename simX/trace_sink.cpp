@@ -0,0 +1,46 @@
+/*******************************************************************************
+ HARPtools by Chad D. Kersey, Summer 2011
+*******************************************************************************/
+#include <iostream>
+
+#include "include/trace_sink.h"
+
+using namespace Harp;
+using namespace std;
+
+TraceSink::TraceSink(const char *path, unsigned mask) :
+  file(fopen(path, "wb")), mask(mask)
+{
+  if (!file) {
+    cerr << "Warning: cannot open trace file " << path << "\n";
+    return;
+  }
+
+  // Large stdio buffer; the writers already hand over records in chunks
+  setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+  TraceFileHeader h = { TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), 0 };
+  fwrite(&h, sizeof(h), 1, file);
+}
+
+TraceSink::~TraceSink() {
+  if (file) fclose(file);
+}
+
+void TraceSink::write(const TraceRecord *records, size_t count) {
+  if (!file || count == 0) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  fwrite(records, sizeof(TraceRecord), count, file);
+}
+
+TraceWriter::TraceWriter(TraceSink &sink) :
+  stages(sink.wants(TRACE_STAGE)), retires(sink.wants(TRACE_RETIRE)),
+  sink(sink)
+{
+  buffer.reserve(CAPACITY);
+}
+
+void TraceWriter::flush() {
+  sink.write(buffer.data(), buffer.size());
+  buffer.clear();
+}